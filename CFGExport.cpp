@@ -0,0 +1,169 @@
+//===-- CFGExport.cpp -------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of the export of CFGs of functions
+// of a module by ModuleRaiser class for use by llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCInstRaiser.h"
+#include "MachineFunctionRaiser.h"
+#include "ModuleRaiser.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/JSON.h"
+#include <algorithm>
+
+namespace {
+// A block of instructions of a function. Start and End are the indices of
+// its first instruction and of the byte following its last instruction.
+struct CFGBlock {
+  uint64_t Start = 0;
+  uint64_t End = 0;
+  unsigned NumInsts = 0;
+  bool IsReturn = false;
+};
+
+// A call instruction at Index, with the index of its target if known
+struct CFGCallSite {
+  uint64_t Index;
+  Optional<uint64_t> Target;
+};
+
+// A jump table through which the block starting at Index branches, with
+// the start indices of its target blocks
+struct CFGJumpTable {
+  uint64_t Index;
+  std::vector<uint64_t> Targets;
+};
+} // end anonymous namespace
+
+// Functions are partitioned into blocks without building their
+// MachineInstrs, except for functions with indirect branches. Jump tables are
+// discovered from the MachineInstrs of such functions, without raising them.
+void ModuleRaiser::writeCFG(raw_ostream &OS) {
+  // Indices are offsets in the text section. Addresses written are those in
+  // the binary.
+  int64_t TextSecAddr = getTextSectionAddress();
+  auto getAddress = [TextSecAddr](uint64_t Index) -> int64_t {
+    return (TextSecAddr > 0) ? Index + TextSecAddr : Index;
+  };
+
+  DenseMap<uint64_t, StringRef> FunctionNames;
+  for (auto MFR : mfRaiserVector)
+    FunctionNames[MFR->getMCInstRaiser()->getFuncStart()] =
+        MFR->getMachineFunction().getName();
+
+  json::OStream J(OS);
+  J.objectBegin();
+  J.attributeBegin("functions");
+  J.arrayBegin();
+  for (auto MFR : mfRaiserVector) {
+    MCInstRaiser *MCIR = MFR->getMCInstRaiser();
+    MachineFunction &MF = MFR->getMachineFunction();
+    bool BuildMachineInstrs = std::any_of(
+        MCIR->const_mcinstr_begin(), MCIR->const_mcinstr_end(),
+        [this](const std::pair<const uint64_t, MCInstOrData> &Entry) {
+          return Entry.second.isMCInst() &&
+                 MIA->isIndirectBranch(Entry.second.getMCInst());
+        });
+
+    std::vector<CFGBlock> Blocks;
+    std::vector<CFGCallSite> Calls;
+    MCIR->partitionBlocks(
+        MIA, this, [&](uint64_t Index, const MCInst &Inst, bool StartsBlock) {
+          if (StartsBlock) {
+            Blocks.emplace_back();
+            Blocks.back().Start = Index;
+          }
+          uint64_t Size = MCIR->getMCInstSize(Index);
+          CFGBlock &Block = Blocks.back();
+          Block.End = Index + Size;
+          Block.NumInsts++;
+          Block.IsReturn = MIA->isReturn(Inst);
+          if (MIA->isCall(Inst)) {
+            uint64_t Target;
+            Calls.push_back({Index, None});
+            if (MIA->evaluateBranch(Inst, Index, Size, Target))
+              Calls.back().Target = Target;
+          }
+          if (BuildMachineInstrs)
+            MCIR->addMachineInstr(MF, MII, Index, Inst, StartsBlock);
+        });
+
+    std::vector<CFGJumpTable> JumpTables;
+    if (BuildMachineInstrs) {
+      MCIR->addCFGEdges(MF);
+      std::vector<DiscoveredJumpTable> DiscoveredJumpTables;
+      MFR->getMachineInstrRaiser()->discoverJumpTables(DiscoveredJumpTables);
+      // Blocks of MF are numbered in the order of Blocks
+      for (const DiscoveredJumpTable &DJT : DiscoveredJumpTables) {
+        CFGJumpTable JT;
+        JT.Index = Blocks[DJT.BranchMBB->getNumber()].Start;
+        for (MachineBasicBlock *TgtMBB : DJT.TargetMBBs)
+          JT.Targets.push_back(Blocks[TgtMBB->getNumber()].Start);
+        JumpTables.push_back(std::move(JT));
+      }
+    }
+
+    J.object([&] {
+      J.attribute("name", MF.getName());
+      J.attribute("start", getAddress(MCIR->getFuncStart()));
+      J.attribute("end", getAddress(MCIR->getFuncEnd()));
+      J.attributeArray("blocks", [&] {
+        for (unsigned BlockNo = 0; BlockNo < Blocks.size(); BlockNo++) {
+          const CFGBlock &Block = Blocks[BlockNo];
+          J.object([&] {
+            J.attribute("start", getAddress(Block.Start));
+            J.attribute("end", getAddress(Block.End));
+            J.attribute("insts", Block.NumInsts);
+            // Targets of return blocks are not their successors
+            J.attributeArray("succs", [&] {
+              if (Block.IsReturn)
+                return;
+              for (uint64_t Target : MCIR->getBlockTargets(BlockNo)) {
+                int64_t TgtBlockNo = MCIR->getMBBNumberOfMCInstOffset(Target);
+                if (TgtBlockNo != -1)
+                  J.value(getAddress(Blocks[TgtBlockNo].Start));
+              }
+            });
+          });
+        }
+      });
+      J.attributeArray("calls", [&] {
+        for (const CFGCallSite &Call : Calls)
+          J.object([&] {
+            J.attribute("site", getAddress(Call.Index));
+            if (!Call.Target.hasValue())
+              return;
+            J.attribute("target", getAddress(*Call.Target));
+            auto Callee = FunctionNames.find(*Call.Target);
+            if (Callee != FunctionNames.end())
+              J.attribute("callee", Callee->second);
+          });
+      });
+      J.attributeArray("jump-tables", [&] {
+        for (const CFGJumpTable &JT : JumpTables)
+          J.object([&] {
+            J.attribute("block", getAddress(JT.Index));
+            J.attributeArray("targets", [&] {
+              for (uint64_t Target : JT.Targets)
+                J.value(getAddress(Target));
+            });
+          });
+      });
+    });
+    // Decoded instructions are not needed once the CFG of the function is
+    // written.
+    MCIR->releaseMCInsts();
+  }
+  J.arrayEnd();
+  J.attributeEnd();
+  J.objectEnd();
+  OS << "\n";
+}
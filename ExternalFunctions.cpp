@@ -53,6 +53,17 @@ Function *ExternalFunctions::Create(StringRef &CFuncName, ModuleRaiser &MR) {
   if (Func != nullptr)
     return Func;
 
+  // A function defined in a shared library raised along with the binary is
+  // declared with the prototype of its raised definition.
+  if (const Function *LibFunc =
+          dyn_cast_or_null<Function>(MR.getLibraryDefinition(CFuncName))) {
+    Func = Function::Create(LibFunc->getFunctionType(),
+                            GlobalValue::ExternalLinkage, CFuncName, M);
+    Func->setCallingConv(CallingConv::C);
+    Func->setDSOLocal(true);
+    return Func;
+  }
+
   auto iter = ExternalFunctions::GlibcFunctions.find(CFuncName);
   if (iter == ExternalFunctions::GlibcFunctions.end()) {
     errs() << CFuncName.data() << "\n";
@@ -138,8 +138,9 @@ FunctionFilter::getOrCreateFunctionByPrototype(FunctionFilter::FuncInfo &Prot) {
 /// Add a new function with given prototype to excluded function list.
 void FunctionFilter::addExcludedFunction(StringRef &PrototypeStr) {
   FunctionFilter::FuncInfo *FPT = new FunctionFilter::FuncInfo();
-  assert(parsePrototypeStr(PrototypeStr, *FPT) &&
-         "Invalid function prototype string!");
+  bool Parsed = parsePrototypeStr(PrototypeStr, *FPT);
+  assert(Parsed && "Invalid function prototype string!");
+  (void)Parsed;
   Function *Funct = getOrCreateFunctionByPrototype(*FPT);
   FPT->StartIdx = 0;
   FPT->Func = Funct;
@@ -159,8 +160,9 @@ void FunctionFilter::addExcludedFunction(StringRef &PrototypeStr) {
 /// Add a new function with given prototype to included function list.
 void FunctionFilter::addIncludedFunction(StringRef &PrototypeStr) {
   FunctionFilter::FuncInfo *FPT = new FunctionFilter::FuncInfo();
-  assert(parsePrototypeStr(PrototypeStr, *FPT) &&
-         "Invalid function prototype string!");
+  bool Parsed = parsePrototypeStr(PrototypeStr, *FPT);
+  assert(Parsed && "Invalid function prototype string!");
+  (void)Parsed;
   StringRef Sym = FPT->getSymName();
   // Check if this function symbol is in the excluded set. Flag and error
   // otherwise.
@@ -0,0 +1,64 @@
+//===-- MCInstDecodeCache.cpp -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of MCInstDecodeCache class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCInstDecodeCache.h"
+#include <algorithm>
+#include <cstring>
+
+// Return the key of the bucket of instructions whose encoding starts with the
+// first Len bytes of Bytes. Len is encoded in the key so that instructions
+// shorter than KeyBytes do not share buckets with longer ones.
+uint64_t MCInstDecodeCache::getKey(ArrayRef<uint8_t> Bytes, unsigned Len) {
+  uint64_t Key = Len;
+  for (unsigned I = 0; I < Len; I++)
+    Key = (Key << 8) | Bytes[I];
+  return Key;
+}
+
+bool MCInstDecodeCache::lookup(ArrayRef<uint8_t> Bytes, MCInst &Inst,
+                               uint64_t &Size) {
+  NumLookups++;
+  unsigned MaxKeyLen = std::min((size_t)KeyBytes, Bytes.size());
+  // Since the decoded instruction at the start of Bytes is determined by its
+  // encoding, at most one cached instruction matches.
+  for (unsigned KeyLen = 1; KeyLen <= MaxKeyLen; KeyLen++) {
+    auto Iter = Buckets.find(getKey(Bytes, KeyLen));
+    if (Iter == Buckets.end())
+      continue;
+    for (const CacheEntry &Entry : Iter->second) {
+      size_t EntrySize = Entry.Bytes.size();
+      if ((EntrySize <= Bytes.size()) &&
+          (std::memcmp(Entry.Bytes.data(), Bytes.data(), EntrySize) == 0)) {
+        Inst = Entry.Inst;
+        Size = EntrySize;
+        NumHits++;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void MCInstDecodeCache::insert(ArrayRef<uint8_t> Bytes, uint64_t Size,
+                               const MCInst &Inst) {
+  assert((Size > 0) && (Size <= Bytes.size()) &&
+         "Unexpected size of instruction to cache");
+  unsigned KeyLen = std::min((uint64_t)KeyBytes, Size);
+  std::vector<CacheEntry> &Bucket = Buckets[getKey(Bytes, KeyLen)];
+  if (Bucket.size() >= MaxEntriesPerBucket)
+    return;
+  CacheEntry Entry;
+  Entry.Bytes.append(Bytes.begin(), Bytes.begin() + Size);
+  Entry.Inst = Inst;
+  Bucket.push_back(std::move(Entry));
+}
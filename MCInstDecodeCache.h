@@ -0,0 +1,63 @@
+//===-- MCInstDecodeCache.h -------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of MCInstDecodeCache class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_MCINSTDECODECACHE_H
+#define LLVM_TOOLS_LLVM_MCTOLL_MCINSTDECODECACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/MC/MCInst.h"
+#include <vector>
+
+using namespace llvm;
+
+// Cache of instructions decoded by a disassembler, keyed by the bytes of the
+// instruction. Repeated encodings of an instruction are decoded only once.
+//
+// The cache is valid only for a single disassembler (and hence for a fixed
+// set of decode mode bits) whose decoded MCInst is a function of the
+// instruction bytes alone - i.e., decoding does not depend on the address of
+// the instruction or on any decoder state, and PC-relative operands are
+// represented as offsets relative to the instruction. X86 disassembler
+// without a symbolizer satisfies these requirements.
+class MCInstDecodeCache {
+public:
+  // Look up the instruction at the start of Bytes. Return true and set Inst
+  // and Size upon finding it.
+  bool lookup(ArrayRef<uint8_t> Bytes, MCInst &Inst, uint64_t &Size);
+  // Record that the first Size bytes of Bytes decode to Inst.
+  void insert(ArrayRef<uint8_t> Bytes, uint64_t Size, const MCInst &Inst);
+
+  uint64_t getNumLookups() const { return NumLookups; }
+  uint64_t getNumHits() const { return NumHits; }
+
+private:
+  struct CacheEntry {
+    SmallVector<uint8_t, 16> Bytes;
+    MCInst Inst;
+  };
+
+  // Instructions are bucketed by the first (at most KeyBytes) bytes of their
+  // encoding. Bucket size is bounded to keep lookups cheap.
+  static const unsigned KeyBytes = 4;
+  static const unsigned MaxEntriesPerBucket = 8;
+
+  static uint64_t getKey(ArrayRef<uint8_t> Bytes, unsigned Len);
+
+  DenseMap<uint64_t, std::vector<CacheEntry>> Buckets;
+  uint64_t NumLookups = 0;
+  uint64_t NumHits = 0;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_MCINSTDECODECACHE_H
@@ -7,6 +7,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "MCInstRaiser.h"
+#include "ModuleRaiser.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/Support/CommandLine.h"
@@ -16,151 +18,218 @@
 #define DEBUG_TYPE "mctoll"
 
 void MCInstRaiser::buildCFG(MachineFunction &MF, const MCInstrAnalysis *MIA,
-                            const MCInstrInfo *MII) {
+                            const MCInstrInfo *MII, const ModuleRaiser *MR) {
+  partitionBlocks(MIA, MR,
+                  [&](uint64_t Index, const MCInst &Inst, bool StartsBlock) {
+                    addMachineInstr(MF, MII, Index, Inst, StartsBlock);
+                  });
+  addCFGEdges(MF);
+
+  // Print the Machine function (which contains the reconstructed
+  // MachineBasicBlocks.
+  if (cl::getRegisteredOptions()["print-after-all"]->getNumOccurrences() > 0) {
+    outs() << "Generated CFG\n";
+    LLVM_DEBUG(MF.dump());
+  }
+}
+
+unsigned MCInstRaiser::partitionBlocks(
+    const MCInstrAnalysis *MIA, const ModuleRaiser *MR,
+    function_ref<void(uint64_t, const MCInst &, bool)> AddInst) {
   bool PrintAll =
       (cl::getRegisteredOptions()["print-after-all"]->getNumOccurrences() > 0);
   if (PrintAll)
     outs() << "Parsed MCInst List\n";
 
-  // Set the first instruction index as the entry of current MBB
+  // Set the first instruction index as the entry of current block
   // Walk the mcInstMap
   //     a) if the current instruction is a target instruction
-  //             record the (entry, current MBB) pair
-  //             create a new MBB
-  //             set current instruction index as entry of current MBB
-  //     b) add raised MachineInstr to current MBB.
+  //             record the (entry, current block) pair
+  //             start a new block
+  //             set current instruction index as entry of current block
+  //     b) add the instruction to current block.
+  // Instructions are walked range by range - those of the function followed
+  // by those of its merged fragments - so that the entry block of the
+  // function is always the first block. The first instruction of a range is
+  // not reached by fall-through from the previously walked instruction.
+  // Padding instructions are not added to blocks. Targets that are padding
+  // instructions are mapped to the block of the instruction following them.
+  // Blocks are numbered in the order they are started, which is the order
+  // of MBB numbers of a MachineFunction they are added to.
   auto targetIndicesEnd = targetIndices.end();
   uint64_t curMBBEntryInstIndex;
+  auto prevMCInstorDataIter = mcInstMap.end();
+  std::vector<uint64_t> paddingTargetIndices;
+  unsigned NumBlocks = 0;
 
-  for (auto mcInstorDataIter = mcInstMap.begin();
-       mcInstorDataIter != mcInstMap.end(); mcInstorDataIter++) {
-    uint64_t mcInstIndex = mcInstorDataIter->first;
-    MCInstOrData mcInstorData = mcInstorDataIter->second;
-    if (PrintAll)
-      mcInstorData.dump();
-
-    // If the current mcInst is a target of some instruction,
-    // i) record the target of previous instruction and fall-through as
-    //    needed.
-    // ii) start a new MachineBasicBlock
-    if (targetIndices.find(mcInstIndex) != targetIndicesEnd) {
-      // Create a map of curMBBEntryInstIndex to the current
-      // MachineBasicBlock for use later to create control flow edges
-      // - except when creating the first MBB.
-      if (MF.size()) {
-        // Find the target MCInst indices of the previous MCInst
-        uint64_t prevMCInstIndex = std::prev(mcInstorDataIter)->first;
-        MCInstOrData prevTextSecBytes = std::prev(mcInstorDataIter)->second;
-        std::vector<uint64_t> prevMCInstTargets;
-
-        // If handling a mcInst
-        if (mcInstorData.isMCInst()) {
-          MCInst mcInst = mcInstorData.getMCInst();
-          // If this instruction is preceeded by mcInst
-          if (prevTextSecBytes.isMCInst()) {
-            MCInst prevMCInst = prevTextSecBytes.getMCInst();
-            // If previous MCInst is a branch
-            if (MIA->isBranch(prevMCInst)) {
-              uint64_t Target;
-              // Get its target
-              if (MIA->evaluateBranch(prevMCInst, prevMCInstIndex,
-                                      (mcInstIndex - prevMCInstIndex),
-                                      Target)) {
-                // Record its target if it is within the function start
-                // and function end.  Branch instructions with such
-                // targets are - for now - treated not to be instructions
-                // but most likely data bytes embedded in instruction stream.
-                // TODO: How to handle any branches out of these bounds?
-                // Does such a situation exist?
-                if ((Target >= FuncStart) && (Target <= FuncEnd)) {
-                  prevMCInstTargets.push_back(Target);
-                  // If previous instruction is a conditional branch, the
-                  // next instruction is also a target
-                  if (MIA->isConditionalBranch(prevMCInst)) {
-                    if ((mcInstIndex >= FuncStart) &&
-                        (mcInstIndex <= FuncEnd)) {
-                      prevMCInstTargets.push_back(mcInstIndex);
+  for (auto FuncRange : getFuncRanges()) {
+    auto rangeEndIter = mcInstMap.lower_bound(FuncRange.second);
+    bool isRangeStart = true;
+    paddingTargetIndices.clear();
+    for (auto mcInstorDataIter = mcInstMap.lower_bound(FuncRange.first);
+         mcInstorDataIter != rangeEndIter; mcInstorDataIter++) {
+      uint64_t mcInstIndex = mcInstorDataIter->first;
+      MCInstOrData mcInstorData = mcInstorDataIter->second;
+      if (PrintAll)
+        mcInstorData.dump();
+
+      bool isTarget = (targetIndices.find(mcInstIndex) != targetIndicesEnd);
+      if (mcInstorData.isMCInst() &&
+          MR->isPaddingInstruction(mcInstorData.getMCInst())) {
+        if (isTarget)
+          paddingTargetIndices.push_back(mcInstIndex);
+        continue;
+      }
+      // A padding instruction preceding the current instruction was a target
+      if (mcInstorData.isMCInst() && !paddingTargetIndices.empty())
+        isTarget = true;
+
+      // If the current mcInst is a target of some instruction,
+      // i) record the target of previous instruction and fall-through as
+      //    needed.
+      // ii) start a new block
+      bool StartsBlock = false;
+      if (isTarget) {
+        // Create a map of curMBBEntryInstIndex to the current block for use
+        // later to create control flow edges - except when starting the
+        // first block.
+        if (NumBlocks > 0) {
+          // Find the target MCInst indices of the previous MCInst
+          uint64_t prevMCInstIndex = prevMCInstorDataIter->first;
+          MCInstOrData prevTextSecBytes = prevMCInstorDataIter->second;
+          SmallVector<uint64_t, 2> prevMCInstTargets;
+
+          // If handling a mcInst
+          if (mcInstorData.isMCInst()) {
+            // If this instruction is preceeded by mcInst
+            if (prevTextSecBytes.isMCInst()) {
+              MCInst prevMCInst = prevTextSecBytes.getMCInst();
+              // If previous MCInst is a branch
+              if (MIA->isBranch(prevMCInst)) {
+                uint64_t Target;
+                // Get its target
+                if (MIA->evaluateBranch(prevMCInst, prevMCInstIndex,
+                                        getMCInstSize(prevMCInstIndex),
+                                        Target)) {
+                  // Record its target if it is within the function start
+                  // and function end.  Branch instructions with such
+                  // targets are - for now - treated not to be instructions
+                  // but most likely data bytes embedded in instruction
+                  // stream.
+                  // TODO: How to handle any branches out of these bounds?
+                  // Does such a situation exist?
+                  if (isMCInstInRange(Target)) {
+                    prevMCInstTargets.push_back(Target);
+                    // If previous instruction is a conditional branch, the
+                    // next instruction is also a target
+                    if (MIA->isConditionalBranch(prevMCInst)) {
+                      if (!isRangeStart && isMCInstInRange(mcInstIndex)) {
+                        prevMCInstTargets.push_back(mcInstIndex);
+                      }
                     }
                   }
                 }
               }
+              // Previous MCInst is not a branch. So, current instruction is
+              // a target
+              else if (!isRangeStart && isMCInstInRange(mcInstIndex))
+                prevMCInstTargets.push_back(mcInstIndex);
             }
-            // Previous MCInst is not a branch. So, current instruction is a
-            // target
-            else if ((mcInstIndex >= FuncStart) && (mcInstIndex <= FuncEnd))
-              prevMCInstTargets.push_back(mcInstIndex);
-
-            // Add to MBB -> targets map
-            MBBNumToMCInstTargetsMap.insert(
-                std::make_pair(MF.back().getNumber(), prevMCInstTargets));
-            mcInstToMBBNum.insert(
-                std::make_pair(curMBBEntryInstIndex, MF.back().getNumber()));
-          } else {
-            // This is preceded by data. Note that this mcInst is a target.
-            // So need to start a new basic block
-            // Add to MBB -> targets map
-            MBBNumToMCInstTargetsMap.insert(
-                std::make_pair(MF.back().getNumber(), prevMCInstTargets));
+            // Else this is preceded by data. Note that this mcInst is a
+            // target. So need to start a new block.
+
+            // Add to block -> targets map
+            MBBNumToMCInstTargetsMap.insert(std::make_pair(
+                NumBlocks - 1,
+                makeArrayRef(prevMCInstTargets).copy(Allocator)));
             mcInstToMBBNum.insert(
-                std::make_pair(curMBBEntryInstIndex, MF.back().getNumber()));
+                std::make_pair(curMBBEntryInstIndex, NumBlocks - 1));
           }
         }
-      }
 
-      // Add the new MBB to MachineFunction
+        // Start the new block
+        if (mcInstorData.isMCInst()) {
+          NumBlocks++;
+          StartsBlock = true;
+          curMBBEntryInstIndex = mcInstIndex;
+          for (auto paddingIndex : paddingTargetIndices)
+            mcInstToMBBNum.insert(
+                std::make_pair(paddingIndex, NumBlocks - 1));
+          paddingTargetIndices.clear();
+        }
+      }
       if (mcInstorData.isMCInst()) {
-        MF.push_back(MF.CreateMachineBasicBlock());
-        curMBBEntryInstIndex = mcInstIndex;
+        assert((NumBlocks > 0) && "Instruction found outside of a block");
+        // Add instruction to current block
+        AddInst(mcInstIndex, mcInstorData.getMCInst(), StartsBlock);
       }
-    }
-    if (mcInstorData.isMCInst()) {
-      // Add raised MachineInstr to current MBB.
-      MF.back().push_back(
-          RaiseMCInst(*MII, MF, mcInstorData.getMCInst(), mcInstIndex));
+      prevMCInstorDataIter = mcInstorDataIter;
+      isRangeStart = false;
     }
   }
 
-  // Add the entry intruction -> MBB map entry for the last MBB
-  if (MF.size()) {
-    MBBNumToMCInstTargetsMap.insert(
-        std::make_pair(MF.back().getNumber(), std::vector<uint64_t>()));
-    mcInstToMBBNum.insert(
-        std::make_pair(curMBBEntryInstIndex, MF.back().getNumber()));
+  // Add the entry intruction -> block map entry for the last block. Record
+  // the target of the branch ending it, if any, since the padding
+  // instructions that may follow it do not start a new block.
+  if (NumBlocks > 0) {
+    SmallVector<uint64_t, 1> lastMCInstTargets;
+    MCInstOrData lastTextSecBytes = prevMCInstorDataIter->second;
+    if (lastTextSecBytes.isMCInst()) {
+      MCInst lastMCInst = lastTextSecBytes.getMCInst();
+      uint64_t lastMCInstIndex = prevMCInstorDataIter->first;
+      uint64_t Target;
+      if (MIA->isBranch(lastMCInst) &&
+          MIA->evaluateBranch(lastMCInst, lastMCInstIndex,
+                              getMCInstSize(lastMCInstIndex), Target) &&
+          isMCInstInRange(Target))
+        lastMCInstTargets.push_back(Target);
+    }
+    MBBNumToMCInstTargetsMap.insert(std::make_pair(
+        NumBlocks - 1, makeArrayRef(lastMCInstTargets).copy(Allocator)));
+    mcInstToMBBNum.insert(std::make_pair(curMBBEntryInstIndex, NumBlocks - 1));
   }
 
+  return NumBlocks;
+}
+
+void MCInstRaiser::addMachineInstr(MachineFunction &MF, const MCInstrInfo *MII,
+                                   uint64_t Index, const MCInst &Inst,
+                                   bool StartsBlock) {
+  if (StartsBlock)
+    MF.push_back(MF.CreateMachineBasicBlock());
+  // Add raised MachineInstr to current MBB.
+  MF.back().push_back(RaiseMCInst(*MII, MF, Inst, Index));
+}
+
+void MCInstRaiser::addCFGEdges(MachineFunction &MF) {
   // Walk all MachineBasicBlocks in MF to add control flow edges
   unsigned mbbCount = MF.getNumBlockIDs();
   for (unsigned mbbIndex = 0; mbbIndex < mbbCount; mbbIndex++) {
     // Get the MBB
     MachineBasicBlock *currentMBB = MF.getBlockNumbered(mbbIndex);
-    std::map<uint64_t, std::vector<uint64_t>>::iterator iter =
-        MBBNumToMCInstTargetsMap.find(mbbIndex);
-    assert(iter != MBBNumToMCInstTargetsMap.end());
-    std::vector<uint64_t> targetMCInstIndices = iter->second;
-    for (auto mbbMCInstTgt : targetMCInstIndices) {
-      std::map<uint64_t, uint64_t>::iterator tgtIter =
-          mcInstToMBBNum.find(mbbMCInstTgt);
+    for (auto mbbMCInstTgt : getBlockTargets(mbbIndex)) {
+      int64_t tgtMBBNum = getMBBNumberOfMCInstOffset(mbbMCInstTgt);
       // If the target is not found, it could be outside the function
       // being constructed.
       // TODO: Need to keep track of all such targets and link them in
       // a later global pass over all MachineFunctions of the module.
-      if (tgtIter == mcInstToMBBNum.end()) {
+      if (tgtMBBNum == -1) {
         outs() << "**** Warning : Index ";
         outs().write_hex(mbbMCInstTgt);
         outs() << " not found\n";
-      } else if (!MF.getBlockNumbered(mbbIndex)->isReturnBlock()) {
-        MachineBasicBlock *succ = MF.getBlockNumbered(tgtIter->second);
+      } else if (!currentMBB->isReturnBlock()) {
+        MachineBasicBlock *succ = MF.getBlockNumbered(tgtMBBNum);
         currentMBB->addSuccessorWithoutProb(succ);
       }
     }
   }
+}
 
-  // Print the Machine function (which contains the reconstructed
-  // MachineBasicBlocks.
-  if (PrintAll) {
-    outs() << "Generated CFG\n";
-    LLVM_DEBUG(MF.dump());
-  }
+ArrayRef<uint64_t> MCInstRaiser::getBlockTargets(unsigned BlockNo) const {
+  auto Iter = MBBNumToMCInstTargetsMap.find(BlockNo);
+  assert(Iter != MBBNumToMCInstTargetsMap.end() &&
+         "Unexpected block number");
+  return Iter->second;
 }
 
 static inline int64_t raiseSignedImm(int64_t val, const DataLayout &dl) {
@@ -234,6 +303,38 @@ void MCInstRaiser::dump() const {
   }
 }
 
+std::vector<std::pair<uint64_t, uint64_t>>
+MCInstRaiser::getFuncRanges() const {
+  std::vector<std::pair<uint64_t, uint64_t>> FuncRanges;
+  FuncRanges.push_back(std::make_pair(FuncStart, FuncEnd));
+  FuncRanges.insert(FuncRanges.end(), FragmentRanges.begin(),
+                    FragmentRanges.end());
+  return FuncRanges;
+}
+
+uint64_t MCInstRaiser::getFuncRangeEnd(uint64_t Offset) const {
+  for (auto Range : FragmentRanges)
+    if ((Offset >= Range.first) && (Offset < Range.second))
+      return Range.second;
+  return FuncEnd;
+}
+
+void MCInstRaiser::mergeFragment(const MCInstRaiser &Fragment) {
+  assert(!isMCInstInRange(Fragment.FuncStart) &&
+         "Attempt to merge overlapping function fragment");
+  for (auto Range : Fragment.getFuncRanges())
+    FragmentRanges.push_back(Range);
+  mcInstMap.insert(Fragment.mcInstMap.begin(), Fragment.mcInstMap.end());
+  targetIndices.insert(Fragment.targetIndices.begin(),
+                       Fragment.targetIndices.end());
+  // Start of the fragment begins a new basic block.
+  targetIndices.insert(Fragment.FuncStart);
+  if (Fragment.dataInCode)
+    dataInCode = true;
+  if (Fragment.undecodedInsts)
+    undecodedInsts = true;
+}
+
 bool MCInstRaiser::adjustFuncEnd(uint64_t n) {
   // NOTE: At present it appears that we only need it to increase the function
   // end index.
@@ -244,6 +345,13 @@ bool MCInstRaiser::adjustFuncEnd(uint64_t n) {
   return true;
 }
 
+void MCInstRaiser::releaseMCInsts() {
+  mcInstMap.clear();
+  targetIndices.clear();
+  MBBNumToMCInstTargetsMap.clear();
+  mcInstToMBBNum.clear();
+}
+
 void MCInstRaiser::addMCInstOrData(uint64_t index, MCInstOrData mcInst) {
   // Set dataInCode flag as appropriate
   if (mcInst.isData() && !dataInCode)
@@ -10,9 +10,13 @@
 #define LLVM_TOOLS_LLVM_MCTOLL_MCINSTRAISER_H
 
 #include "MCInstOrData.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/MC/MCInstrAnalysis.h"
+#include "llvm/Support/Allocator.h"
 #include <map>
 #include <set>
 #include <utility>
@@ -20,40 +24,82 @@
 
 using namespace llvm;
 
+class ModuleRaiser;
+
 // Class that encapsulates raising for MCInst vector to MachineInstrs
 class MCInstRaiser {
 public:
   using const_mcinst_iter = std::map<uint64_t, MCInstOrData>::const_iterator;
 
-  MCInstRaiser(uint64_t Start, uint64_t End)
-      : FuncStart(Start), FuncEnd(End), dataInCode(false){};
+  MCInstRaiser(uint64_t Start, uint64_t End, BumpPtrAllocator &Allocator)
+      : Allocator(Allocator), FuncStart(Start), FuncEnd(End),
+        dataInCode(false), undecodedInsts(false){};
 
   void addTarget(uint64_t targetIndex) {
     // Add targetIndex only if it falls within the function start and end
-    if (!((targetIndex >= FuncStart) && (targetIndex <= FuncEnd)))
+    if (!isMCInstInRange(targetIndex))
       return;
     targetIndices.insert(targetIndex);
   }
 
   void addMCInstOrData(uint64_t index, MCInstOrData mcInst);
+  // Release the decoded instructions and the CFG information built from
+  // them. Function start and end offsets are retained.
+  void releaseMCInsts();
+  // Release the block targets, which are allocated using the allocator of
+  // the function, before the allocator is reset.
+  void releaseBlockTargets() { MBBNumToMCInstTargetsMap.clear(); }
 
   void buildCFG(MachineFunction &MF, const MCInstrAnalysis *mia,
-                const MCInstrInfo *mii);
-
-  std::set<uint64_t> getTargetIndices() const { return targetIndices; }
+                const MCInstrInfo *mii, const ModuleRaiser *MR);
+
+  // Partition the instructions of the function into blocks, calling AddInst
+  // with the index of each instruction, the instruction and whether it
+  // starts a new block, in block order. Blocks are numbered from 0 in the
+  // order they are started. Return the number of blocks. Expected to be
+  // called at most once, by buildCFG or in its place.
+  unsigned
+  partitionBlocks(const MCInstrAnalysis *MIA, const ModuleRaiser *MR,
+                  function_ref<void(uint64_t, const MCInst &, bool)> AddInst);
+  // Add the MachineInstr raised from Inst at Index to MF, in a new MBB if
+  // StartsBlock is set. For use as the AddInst of partitionBlocks.
+  void addMachineInstr(MachineFunction &MF, const MCInstrInfo *MII,
+                       uint64_t Index, const MCInst &Inst, bool StartsBlock);
+  // Add control flow edges between MBBs of MF added by addMachineInstr
+  void addCFGEdges(MachineFunction &MF);
+  // Return the indices of the instructions the last instruction of block
+  // number BlockNo transfers control to. These include the fall-through
+  // instruction, if any.
+  ArrayRef<uint64_t> getBlockTargets(unsigned BlockNo) const;
+
+  const std::set<uint64_t> &getTargetIndices() const { return targetIndices; }
   uint64_t getFuncStart() const { return FuncStart; }
   uint64_t getFuncEnd() const { return FuncEnd; }
   // Change the value of function end to a new value greater than current value
   bool adjustFuncEnd(uint64_t n);
-  // Is Index in range of this function?
-  bool isMCInstInRange(uint64_t Index) {
-    return ((Index >= FuncStart) && (Index <= FuncEnd));
+  // Is Index in range of this function or any of its merged fragments?
+  bool isMCInstInRange(uint64_t Index) const {
+    if ((Index >= FuncStart) && (Index <= FuncEnd))
+      return true;
+    for (auto Range : FragmentRanges)
+      if ((Index >= Range.first) && (Index <= Range.second))
+        return true;
+    return false;
   }
+  // Merge instructions of Fragment - a part of this function placed
+  // elsewhere in the binary - into this function.
+  void mergeFragment(const MCInstRaiser &Fragment);
+  // Return the start and end offsets of this function followed by those of
+  // its merged fragments.
+  std::vector<std::pair<uint64_t, uint64_t>> getFuncRanges() const;
   // Dump routine
   void dump() const;
   // Data in Code
   void setDataInCode(bool v) { dataInCode = v; }
   bool hasDataInCode() { return dataInCode; }
+  // Instructions that failed to decode
+  void setUndecodedInsts(bool v) { undecodedInsts = v; }
+  bool hasUndecodedInsts() const { return undecodedInsts; }
 
   // Get the MBB number that corresponds to MCInst at Offset.
   // MBB has the raised MachineInstr corresponding to MCInst at
@@ -72,23 +118,33 @@ public:
     return mcInstMap.find(Offset);
   }
 
+  const_mcinst_iter const_mcinstr_begin() const { return mcInstMap.begin(); }
   const_mcinst_iter const_mcinstr_end() const { return mcInstMap.end(); }
 
+  // Allocator of the per-function objects built while raising the function.
+  // These are released together when the function is released.
+  BumpPtrAllocator &getAllocator() { return Allocator; }
+
   // Get the size of instruction
   uint64_t getMCInstSize(uint64_t Offset) const {
     const_mcinst_iter Iter = mcInstMap.find(Offset);
     const_mcinst_iter End = mcInstMap.end();
     assert(Iter != End && "Attempt to find MCInst at non-existent offset");
 
+    // Instructions of merged fragments are not contiguous with those of
+    // the function. So the next instruction is considered only if it is in
+    // the same range as the instruction at Offset.
+    uint64_t RangeEnd = getFuncRangeEnd(Offset);
     if (Iter.operator++() != End) {
       uint64_t NextOffset = (*Iter).first;
-      return NextOffset - Offset;
+      if (NextOffset < RangeEnd)
+        return NextOffset - Offset;
     }
 
-    // The instruction at Offset is the last instriuction in the input stream
-    assert(Offset < FuncEnd &&
+    // The instruction at Offset is the last instriuction in its range
+    assert(Offset < RangeEnd &&
            "Attempt to find MCInst at offset beyond function end");
-    return FuncEnd - Offset;
+    return RangeEnd - Offset;
   }
 
   uint64_t getMCInstIndex(const MachineInstr &MI) {
@@ -127,16 +183,26 @@ private:
   // representation of the MCinst at the index, mci
   std::map<uint64_t, uint64_t> mcInstToMBBNum;
 
-  std::map<uint64_t, std::vector<uint64_t>> MBBNumToMCInstTargetsMap;
+  // A map of MachineBasicBlock number to the indices of MCInsts targeted by
+  // its last instruction. Index arrays are allocated using Allocator.
+  DenseMap<unsigned, ArrayRef<uint64_t>> MBBNumToMCInstTargetsMap;
+  BumpPtrAllocator &Allocator;
+  // Return the end offset of the range that contains Offset.
+  uint64_t getFuncRangeEnd(uint64_t Offset) const;
   MachineInstr *RaiseMCInst(const MCInstrInfo &, MachineFunction &, MCInst,
                             uint64_t);
   // Start and End offsets of the array of MCInsts in mcInstVector
   uint64_t FuncStart;
   uint64_t FuncEnd;
+  // Start and End offsets of fragments of this function that were split
+  // from it by the compiler and merged back.
+  std::vector<std::pair<uint64_t, uint64_t>> FragmentRanges;
   // Flag to indicate that the mcInstVector includes data (or uint32_ sized
   // quantities that the disassembler was unable to recognize as instructions
   // and are considered data
   bool dataInCode;
+  // Flag to indicate that some instructions of the function failed to decode
+  bool undecodedInsts;
 };
 
 #endif // LLVM_TOOLS_LLVM_MCTOLL_MCINSTRAISER_H
@@ -7,6 +7,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "MachineFunctionRaiser.h"
+#include "OpcodeCoverage.h"
+#include "PhaseTimes.h"
+#include "RaisedCodeMetrics.h"
+#include "llvm-mctoll.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Target/TargetMachine.h"
 
 bool MachineFunctionRaiser::runRaiserPasses() {
@@ -31,10 +40,94 @@ void MachineFunctionRaiser::cleanupRaisedFunction() {
     BB->removeFromParent();
 }
 
+// Verify the raised function. Report the function along with its address in
+// the input binary if it is found to be broken.
+bool MachineFunctionRaiser::verifyRaisedFunction() {
+  Function *RaisedFunc = getRaisedFunction();
+  std::string ErrMsg;
+  raw_string_ostream ErrStream(ErrMsg);
+  if (!verifyFunction(*RaisedFunc, &ErrStream))
+    return true;
+
+  int64_t TextSecAddr = MR->getTextSectionAddress();
+  uint64_t FuncAddr = mcInstRaiser->getFuncStart();
+  if (TextSecAddr > 0)
+    FuncAddr += TextSecAddr;
+  errs() << "**** Error : Raised function " << RaisedFunc->getName()
+         << " at address 0x";
+  errs().write_hex(FuncAddr);
+  errs() << " failed verification\n" << ErrStream.str();
+  return false;
+}
+
+// Replace the body of the raised function with a thunk that calls the native
+// code of the function in the copy of the text section of the input binary
+// embedded in the raised module. The thunk passes its arguments to, and
+// returns the value returned by, the native code per the prototype
+// discovered for the function.
+void MachineFunctionRaiser::bindRaisedFunctionToNativeCode() {
+  Function *RaisedFunc = getRaisedFunction();
+  uint64_t FuncOffset = mcInstRaiser->getFuncStart();
+  outs() << "**** Warning : Function " << RaisedFunc->getName()
+         << " not raised. Binding it to native code at text section offset 0x";
+  outs().write_hex(FuncOffset);
+  outs() << "\n";
+
+  if (!RaisedFunc->isDeclaration())
+    RaisedFunc->deleteBody();
+
+  LLVMContext &Ctx = M.getContext();
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+  GlobalVariable *NativeText = MR->getNativeTextGlobal();
+  Constant *Idx[2] = {ConstantInt::get(Int64Ty, 0),
+                      ConstantInt::get(Int64Ty, FuncOffset)};
+  Constant *NativeAddr = ConstantExpr::getInBoundsGetElementPtr(
+      NativeText->getValueType(), NativeText, Idx);
+  FunctionType *FTy = RaisedFunc->getFunctionType();
+  Constant *Callee = ConstantExpr::getBitCast(NativeAddr, FTy->getPointerTo());
+
+  BasicBlock *EntryBB = BasicBlock::Create(Ctx, "entry", RaisedFunc);
+  std::vector<Value *> Args;
+  for (Argument &Arg : RaisedFunc->args())
+    Args.push_back(&Arg);
+  CallInst *Call = CallInst::Create(FTy, Callee, Args, "", EntryBB);
+  // Forward the call, including any variable arguments, to the native code.
+  Call->setTailCallKind(CallInst::TCK_MustTail);
+  if (FTy->getReturnType()->isVoidTy())
+    ReturnInst::Create(Ctx, EntryBB);
+  else
+    ReturnInst::Create(Ctx, Call, EntryBB);
+}
+
+// Release the objects allocated to raise the function and, if
+// ReleaseMachineFunction is set, the decoded instructions and the
+// MachineBasicBlocks of the function, if the instruction raiser does not need
+// them any more.
+void MachineFunctionRaiser::releaseRaiserState(bool ReleaseMachineFunction) {
+  if (machineInstRaiser == nullptr || !machineInstRaiser->releaseRaiserState())
+    return;
+
+  mcInstRaiser->releaseBlockTargets();
+  Allocator.Reset();
+
+  if (!ReleaseMachineFunction)
+    return;
+  mcInstRaiser->releaseMCInsts();
+  while (!MF.empty())
+    MF.erase(MF.begin());
+}
+
 // NOTE : The following ModuleRaiser class functions are defined here as they
 // reference MachineFunctionRaiser class that has a forward declaration in
 // ModuleRaiser.h.
 
+ModuleRaiser::~ModuleRaiser() {
+  for (auto MFR : mfRaiserVector)
+    delete MFR;
+  if (FFT != nullptr)
+    delete FFT;
+}
+
 Function *ModuleRaiser::getRaisedFunctionAt(uint64_t Index) const {
   int64_t TextSecAddr = getTextSectionAddress();
   for (auto MFR : mfRaiserVector)
@@ -44,6 +137,16 @@ Function *ModuleRaiser::getRaisedFunctionAt(uint64_t Index) const {
   return nullptr;
 }
 
+const GlobalValue *ModuleRaiser::getLibraryDefinition(StringRef Name) const {
+  for (const Module *LM : LibraryModules) {
+    const GlobalValue *GV = LM->getNamedValue(Name);
+    if ((GV != nullptr) && !GV->isDeclaration())
+      return GV;
+  }
+
+  return nullptr;
+}
+
 const RelocationRef *ModuleRaiser::getDynRelocAtOffset(uint64_t Loc) const {
   if (DynRelocs.empty())
     return nullptr;
@@ -91,15 +194,19 @@ Function *ModuleRaiser::getCalledFunctionUsingTextReloc(uint64_t Loc,
   return nullptr;
 }
 
-bool ModuleRaiser::runMachineFunctionPasses() {
+bool ModuleRaiser::runMachineFunctionPasses(bool ReleaseRaisedFunctions,
+                                            bool VerifyRaisedFunctions,
+                                            bool NativeFallback) {
   bool Success = true;
 
+  if (Times != nullptr)
+    Times->start("build-cfg");
   // For each of the functions, run passes to set up for instruction raising.
   for (auto MFR : mfRaiserVector) {
     // 1. Build CFG
     MCInstRaiser *MCIR = MFR->getMCInstRaiser();
     // Populates the MachineFunction with CFG.
-    MCIR->buildCFG(MFR->getMachineFunction(), MIA, MII);
+    MCIR->buildCFG(MFR->getMachineFunction(), MIA, MII, this);
 
     // 2. Construct function prototype.
     // Knowing the function prototypes prior to raising the instructions
@@ -114,13 +221,231 @@ bool ModuleRaiser::runMachineFunctionPasses() {
     }
   }
 
-  // Run instruction raiser passes.
-  for (auto MFR : mfRaiserVector)
-    Success |= MFR->runRaiserPasses();
+  // Run instruction raiser passes. Raising a function needs the prototypes of
+  // all functions it calls. So instructions of a function are raised only
+  // after the prototypes of all functions are constructed. Once a function
+  // is raised, the state used to raise it is released so that the memory
+  // held by raised functions is not retained while the remaining functions
+  // are raised and the module is emitted. Its machine function and decoded
+  // instructions are released only if ReleaseRaisedFunctions is set.
+  // Each function is verified as soon as it is raised so that a broken
+  // function is reported along with its address before any other function
+  // is raised.
+  // With native fallback, a function with instructions that failed to decode
+  // is not raised. Such a function, and a function that fails to raise or
+  // verify, is bound to its native code instead, if its native code can run
+  // from the copy of the text section in the raised module. Otherwise, a
+  // function that fails to raise or verify fails raising of the module.
+  if (Times != nullptr)
+    Times->start("raise");
+  for (auto MFR : mfRaiserVector) {
+    bool Raised = false;
+    if (!(NativeFallback && MFR->getMCInstRaiser()->hasUndecodedInsts())) {
+      Raised = MFR->runRaiserPasses();
+      if (!Raised && !NativeFallback)
+        errs() << "**** Error : Failed to raise function "
+               << MFR->getRaisedFunction()->getName() << "\n";
+      if (Raised && VerifyRaisedFunctions && !MFR->verifyRaisedFunction())
+        Raised = false;
+    }
+    if (Coverage != nullptr)
+      Coverage->recordFunction(*MFR, Raised);
+    if ((Metrics != nullptr) && Raised)
+      Metrics->recordFunction(*MFR);
+    if (NativeFallback && !Raised) {
+      if (canBindToNativeCode(*MFR))
+        MFR->bindRaisedFunctionToNativeCode();
+      else {
+        errs() << "**** Error : Function "
+               << MFR->getRaisedFunction()->getName()
+               << " can not be bound to native code\n";
+        Success = false;
+      }
+    } else
+      Success &= Raised;
+    MFR->releaseRaiserState(ReleaseRaisedFunctions);
+  }
+
+  // Module-level checks of the raised module are run once all functions are
+  // raised. Functions found broken are not reported again.
+  if (VerifyRaisedFunctions && Success && verifyModule(*M, &errs())) {
+    errs() << "**** Error : Raised module failed verification\n";
+    Success = false;
+  }
 
   return Success;
 }
 
+// Return the MachineFunctionRaiser of the function whose range includes
+// Index, given the map of function start -> MachineFunctionRaiser. Return
+// nullptr if none found.
+static MachineFunctionRaiser *findMachineFunctionRaiserWithIndex(
+    const std::map<uint64_t, MachineFunctionRaiser *> &FuncStartMap,
+    uint64_t Index) {
+  // Function end is the start of the following function. So a function
+  // starting at Index is found first. Else, the function that may include
+  // Index is the one with the closest start preceding it.
+  auto Iter = FuncStartMap.upper_bound(Index);
+  if (Iter == FuncStartMap.begin())
+    return nullptr;
+  MachineFunctionRaiser *MFR = std::prev(Iter)->second;
+  if ((MFR->getMCInstRaiser()->getFuncStart() == Index) ||
+      MFR->getMCInstRaiser()->isMCInstInRange(Index))
+    return MFR;
+  return nullptr;
+}
+
+// Compilers split rarely executed code of a function into a separate
+// fragment - named <function>.cold or <function>.cold.<n> by GCC - that is
+// placed away from the function. Such a fragment is disassembled as a
+// function of its own, and the branches between the function and the
+// fragment are dropped while building the CFGs. Merge each fragment into the
+// function it was split from so that the function is raised with complete
+// control flow.
+// A fragment is detected by its name or, absent a name, by branches between
+// it and another function in both directions with at least one branch from
+// it into the interior of the other. Functions are not expected to branch
+// into the middle of other functions; branches to the start of a function
+// are tail calls.
+bool ModuleRaiser::mergeSplitFunctionFragments() {
+  // Collect targets of direct calls, and of branches from each function to
+  // other functions. A call target is a function and not a fragment.
+  std::set<uint64_t> CallTargets;
+  std::map<MachineFunctionRaiser *, std::set<uint64_t>> ExternalBranchTargets;
+  for (auto MFR : mfRaiserVector) {
+    MCInstRaiser *MCIR = MFR->getMCInstRaiser();
+    for (auto Iter = MCIR->const_mcinstr_begin();
+         Iter != MCIR->const_mcinstr_end(); Iter++) {
+      if (!Iter->second.isMCInst())
+        continue;
+      MCInst Inst = Iter->second.getMCInst();
+      uint64_t Target;
+      if (!MIA->isBranch(Inst) && !MIA->isCall(Inst))
+        continue;
+      if (!MIA->evaluateBranch(Inst, Iter->first,
+                               MCIR->getMCInstSize(Iter->first), Target))
+        continue;
+      if (MIA->isCall(Inst))
+        CallTargets.insert(Target);
+      else if (!MCIR->isMCInstInRange(Target))
+        ExternalBranchTargets[MFR].insert(Target);
+    }
+  }
+
+  // Map of function start -> MachineFunctionRaiser, to look up the function
+  // that a branch target is in.
+  std::map<uint64_t, MachineFunctionRaiser *> FuncStartMap;
+  for (auto MFR : mfRaiserVector)
+    FuncStartMap.emplace(MFR->getMCInstRaiser()->getFuncStart(), MFR);
+
+  // Map of fragment -> function it was split from
+  std::map<MachineFunctionRaiser *, MachineFunctionRaiser *> FragmentParentMap;
+  for (auto MFR : mfRaiserVector) {
+    MCInstRaiser *MCIR = MFR->getMCInstRaiser();
+    StringRef FuncName = MFR->getMachineFunction().getFunction().getName();
+    MachineFunctionRaiser *ParentMFR = nullptr;
+    size_t ColdSuffixPos = FuncName.find(".cold");
+    if ((ColdSuffixPos != StringRef::npos) && (ColdSuffixPos != 0) &&
+        (FuncName.drop_front(ColdSuffixPos + 5).empty() ||
+         FuncName.drop_front(ColdSuffixPos + 5).startswith("."))) {
+      StringRef ParentName = FuncName.substr(0, ColdSuffixPos);
+      for (auto CandMFR : mfRaiserVector)
+        if (CandMFR->getMachineFunction().getFunction().getName() ==
+            ParentName)
+          ParentMFR = CandMFR;
+    } else if (CallTargets.find(MCIR->getFuncStart()) == CallTargets.end()) {
+      bool HasMultipleParents = false;
+      for (auto Target : ExternalBranchTargets[MFR]) {
+        MachineFunctionRaiser *TargetMFR =
+            findMachineFunctionRaiserWithIndex(FuncStartMap, Target);
+        // Branch to start of a function is a tail call.
+        if ((TargetMFR == nullptr) ||
+            (TargetMFR->getMCInstRaiser()->getFuncStart() == Target))
+          continue;
+        if ((ParentMFR != nullptr) && (ParentMFR != TargetMFR))
+          HasMultipleParents = true;
+        ParentMFR = TargetMFR;
+      }
+      // The function it was split from is expected to branch to the fragment.
+      if (ParentMFR != nullptr) {
+        bool HasBranchFromParent = false;
+        for (auto Target : ExternalBranchTargets[ParentMFR])
+          if (MCIR->isMCInstInRange(Target) &&
+              (findMachineFunctionRaiserWithIndex(FuncStartMap, Target) ==
+               MFR))
+            HasBranchFromParent = true;
+        if (!HasBranchFromParent)
+          ParentMFR = nullptr;
+      }
+      if (HasMultipleParents)
+        ParentMFR = nullptr;
+    }
+    if ((ParentMFR != nullptr) && (ParentMFR != MFR))
+      FragmentParentMap.emplace(MFR, ParentMFR);
+  }
+
+  if (FragmentParentMap.empty())
+    return true;
+
+  // Merge each fragment into the outermost function it was split from.
+  // Fragments are merged in the order of their addresses.
+  std::set<MachineFunctionRaiser *> MergedParents;
+  std::set<MachineFunctionRaiser *> MergedFragments;
+  for (auto FragmentMFR : mfRaiserVector) {
+    auto FragmentIter = FragmentParentMap.find(FragmentMFR);
+    if (FragmentIter == FragmentParentMap.end())
+      continue;
+    MachineFunctionRaiser *ParentMFR = FragmentIter->second;
+    unsigned ChainLength = 0;
+    auto ParentIter = FragmentParentMap.find(ParentMFR);
+    while ((ParentIter != FragmentParentMap.end()) &&
+           (ChainLength++ < FragmentParentMap.size())) {
+      ParentMFR = ParentIter->second;
+      ParentIter = FragmentParentMap.find(ParentMFR);
+    }
+    // Fragments that form a cycle are not merged.
+    if (ParentIter != FragmentParentMap.end())
+      continue;
+    ParentMFR->getMCInstRaiser()->mergeFragment(
+        *FragmentMFR->getMCInstRaiser());
+    MergedParents.insert(ParentMFR);
+    MergedFragments.insert(FragmentMFR);
+  }
+
+  // Record branch targets that are now within the merged functions.
+  for (auto MFR : MergedParents) {
+    MCInstRaiser *MCIR = MFR->getMCInstRaiser();
+    for (auto Iter = MCIR->const_mcinstr_begin();
+         Iter != MCIR->const_mcinstr_end(); Iter++) {
+      if (!Iter->second.isMCInst())
+        continue;
+      MCInst Inst = Iter->second.getMCInst();
+      if (!MIA->isBranch(Inst) || MIA->isCall(Inst))
+        continue;
+      uint64_t InstSize = MCIR->getMCInstSize(Iter->first);
+      uint64_t Target;
+      if (MIA->evaluateBranch(Inst, Iter->first, InstSize, Target))
+        MCIR->addTarget(Target);
+      MCIR->addTarget(Iter->first + InstSize);
+    }
+  }
+
+  // Delete merged fragments along with their place-holder functions.
+  auto IsMergedFragment = [&MergedFragments](MachineFunctionRaiser *MFR) {
+    return MergedFragments.count(MFR) != 0;
+  };
+  mfRaiserVector.erase(std::remove_if(mfRaiserVector.begin(),
+                                      mfRaiserVector.end(), IsMergedFragment),
+                       mfRaiserVector.end());
+  for (auto FragmentMFR : MergedFragments) {
+    Function &PlaceholderFunc = FragmentMFR->getMachineFunction().getFunction();
+    delete FragmentMFR;
+    MMI->deleteMachineFunctionFor(PlaceholderFunc);
+    PlaceholderFunc.eraseFromParent();
+  }
+  return true;
+}
+
 // Get the MachineFunction associated with the placeholder
 // function corresponding to raised function.
 MachineFunction *ModuleRaiser::getMachineFunction(Function *RF) {
@@ -165,6 +490,100 @@ bool ModuleRaiser::collectTextSectionRelocs(const SectionRef &TextSec) {
   return true;
 }
 
+// Return the global at the start of the copy of the text section of the
+// input binary embedded in the raised module, creating the copy if needed.
+// A global variable can not be placed in an executable section. So the copy
+// is emitted as module-level inline assembly into a section of its own, and
+// the global is a declaration of its start. The symbol is named after the
+// input binary so that copies from binaries linked into one module do not
+// clash.
+GlobalVariable *ModuleRaiser::getNativeTextGlobal() const {
+  std::string Name = "__mctoll_native_text.";
+  for (char C : sys::path::filename(Obj->getFileName()))
+    Name += isAlnum(C) ? C : '_';
+  GlobalVariable *NativeText = M->getNamedGlobal(Name);
+  if (NativeText != nullptr)
+    return NativeText;
+
+  assert(TextSectionIndex >= 0 && "Unexpected negative index of text section");
+  StringRef Contents;
+  uint64_t Alignment = 1;
+  for (SectionRef Sec : Obj->sections())
+    if (Sec.getIndex() == (unsigned)TextSectionIndex) {
+      Contents = unwrapOrError(Sec.getContents(), Obj->getFileName());
+      Alignment = std::max<uint64_t>(Sec.getAlignment(), 1);
+      break;
+    }
+
+  ArrayType *TextTy =
+      ArrayType::get(Type::getInt8Ty(M->getContext()), Contents.size());
+  NativeText = new GlobalVariable(*M, TextTy, true /* isConstant */,
+                                  GlobalValue::ExternalLinkage, nullptr, Name);
+  NativeText->setVisibility(GlobalValue::HiddenVisibility);
+  NativeText->setDSOLocal(true);
+
+  std::string Asm;
+  raw_string_ostream AsmOS(Asm);
+  AsmOS << "\t.pushsection .mctoll.native.text,\"ax\",@progbits\n"
+        << "\t.p2align " << Log2_64(Alignment) << "\n"
+        << "\t.globl " << Name << "\n"
+        << "\t.hidden " << Name << "\n"
+        << Name << ":\n";
+  for (size_t I = 0; I < Contents.size(); I++) {
+    AsmOS << ((I % 16 == 0) ? "\t.byte " : ",")
+          << (unsigned)Contents.bytes_begin()[I];
+    if ((I % 16 == 15) || (I + 1 == Contents.size()))
+      AsmOS << "\n";
+  }
+  AsmOS << "\t.popsection\n";
+  M->appendModuleInlineAsm(AsmOS.str());
+  return NativeText;
+}
+
+bool ModuleRaiser::isDataSymbolAddress(uint64_t Addr) const {
+  auto CacheIter = DataSymbolAddresses.find(Addr);
+  if (CacheIter != DataSymbolAddresses.end())
+    return CacheIter->second;
+
+  if (!DataSymbolRangesBuilt) {
+    DataSymbolRangesBuilt = true;
+    if (auto *ElfObj = dyn_cast<ELFObjectFileBase>(Obj)) {
+      std::vector<std::pair<uint64_t, uint64_t>> Ranges;
+      for (ELFSymbolRef Symbol : ElfObj->symbols()) {
+        if ((Symbol.getELFType() != ELF::STT_OBJECT) || (Symbol.getSize() == 0))
+          continue;
+        Expected<uint64_t> SymAddr = Symbol.getAddress();
+        if (!SymAddr) {
+          consumeError(SymAddr.takeError());
+          continue;
+        }
+        Ranges.emplace_back(*SymAddr, *SymAddr + Symbol.getSize());
+      }
+      // Merge overlapping ranges, so that at most one range may contain an
+      // address.
+      llvm::sort(Ranges);
+      for (auto &Range : Ranges)
+        if (!DataSymbolRanges.empty() &&
+            (Range.first <= DataSymbolRanges.back().second))
+          DataSymbolRanges.back().second =
+              std::max(DataSymbolRanges.back().second, Range.second);
+        else
+          DataSymbolRanges.push_back(Range);
+    }
+  }
+
+  // Find the last range that starts at or below Addr
+  auto Iter = std::upper_bound(
+      DataSymbolRanges.begin(), DataSymbolRanges.end(), Addr,
+      [](uint64_t A, const std::pair<uint64_t, uint64_t> &Range) {
+        return A < Range.first;
+      });
+  bool Found =
+      (Iter != DataSymbolRanges.begin()) && (Addr < std::prev(Iter)->second);
+  DataSymbolAddresses.emplace(Addr, Found);
+  return Found;
+}
+
 // Return text section address; or -1 if text section is not found
 int64_t ModuleRaiser::getTextSectionAddress() const {
   if (!Obj->isELF())
@@ -31,13 +31,16 @@ public:
                         uint64_t Start, uint64_t End)
       : MF(MF), M(M), machineInstRaiser(nullptr), MR(MR) {
     
-    mcInstRaiser = new MCInstRaiser(Start, End);
+    mcInstRaiser = new MCInstRaiser(Start, End, Allocator);
 
     // The new MachineFunction is not in SSA form, yet
     MF.getProperties().reset(MachineFunctionProperties::Property::IsSSA);
   };
 
-  virtual ~MachineFunctionRaiser() { delete mcInstRaiser; }
+  virtual ~MachineFunctionRaiser() {
+    delete machineInstRaiser;
+    delete mcInstRaiser;
+  }
 
   bool runRaiserPasses();
 
@@ -65,10 +68,25 @@ public:
   // Cleanup orphaned empty basic blocks from raised function
   void cleanupRaisedFunction();
 
+  // Verify the raised function. Return false if it is broken.
+  bool verifyRaisedFunction();
+
+  // Replace the body of the raised function with a thunk that calls the
+  // native code of the function.
+  void bindRaisedFunctionToNativeCode();
+
+  // Release the per-function state no longer needed once the function is
+  // raised. If ReleaseMachineFunction is set, the decoded instructions and
+  // the MachineBasicBlocks of the function are released as well.
+  void releaseRaiserState(bool ReleaseMachineFunction);
+
 private:
   MachineFunction &MF;
   Module &M;
 
+  // Allocator of per-function objects of the raisers of this function
+  BumpPtrAllocator Allocator;
+
   // Data members built and used by this class
   MCInstRaiser *mcInstRaiser;
   MachineInstructionRaiser *machineInstRaiser;
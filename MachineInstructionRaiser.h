@@ -17,6 +17,10 @@
 
 #include "MCInstRaiser.h"
 #include "ModuleRaiser.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/LoopTraversal.h"
 #include "llvm/CodeGen/MachineFunction.h"
 
 using namespace llvm;
@@ -29,17 +33,25 @@ typedef struct {
   BasicBlock *CandidateBlock;
   // This is the MachineInstr that needs to be raised
   const MachineInstr *CandidateMachineInstr;
-  // A vector of values that could be of use while raising
+  // An array of values that could be of use while raising
   // CandidateMachineInstr. If it is a call instruction,
-  // this vector has the Values corresponding to argument
+  // this array has the Values corresponding to argument
   // registers (TODO : need to handles arguments passed on stack)
   // If this is a conditional branch instruction, it contains the
-  // EFLAG bit values.
-  std::vector<Value *> RegValues;
+  // EFLAG bit values. The array is allocated using the allocator of
+  // the function.
+  ArrayRef<Value *> RegValues;
   // Flag to indicate that CandidateMachineInstr has been raised
   bool Raised;
 } ControlTransferInfo;
 
+// A jump table discovered in a MachineFunction - the block that branches
+// through it and the blocks that are its targets, in table order.
+struct DiscoveredJumpTable {
+  MachineBasicBlock *BranchMBB;
+  std::vector<MachineBasicBlock *> TargetMBBs;
+};
+
 class MachineInstructionRaiser {
 public:
   MachineInstructionRaiser() = delete;
@@ -55,15 +67,39 @@ public:
   virtual Value *getRegOrArgValue(unsigned PReg, int MBBNo) = 0;
   virtual bool buildFuncArgTypeVector(const std::set<MCPhysReg> &,
                                       std::vector<Type *> &) = 0;
+  // Release the state used to raise the function, once it is raised. Return
+  // true if MF and the decoded instructions of the function are not needed
+  // by any later pass and may be released as well.
+  virtual bool releaseRaiserState() { return false; }
+  // Return the number of values of status flags computed in the raised
+  // function. Valid only until the raiser state is released.
+  virtual unsigned getNumFlagValues() const { return 0; }
+  // Discover jump tables of MF, whose CFG is expected to be built, without
+  // raising the function or modifying MF. Indirect branches that are not
+  // recognized as branches through a jump table are skipped.
+  virtual void
+  discoverJumpTables(std::vector<DiscoveredJumpTable> &JumpTables) {}
+  // Return the opcode of the instruction that failed to raise, if known
+  Optional<unsigned> getFailedOpcode() const { return FailedOpcode; }
 
   Function *getRaisedFunction() { return raisedFunction; }
   MCInstRaiser *getMCInstRaiser() { return mcInstRaiser; }
   MachineFunction &getMF() { return MF; };
   const ModuleRaiser *getModuleRaiser() { return MR; }
 
-  std::vector<ControlTransferInfo *> getControlTransferInfo() {
-    return CTInfo;
-  };
+  ArrayRef<ControlTransferInfo *> getControlTransferInfo() { return CTInfo; };
+
+  // Return the loop traversal order of MachineBasicBlocks of MF. The order is
+  // computed once, upon first request, and is expected to be requested only
+  // after the CFG of MF is finalized.
+  const LoopTraversal::TraversalOrder &getTraversalOrder() {
+    if (!traversalOrderValid) {
+      LoopTraversal Traversal;
+      traversalOrder = Traversal.traverse(MF);
+      traversalOrderValid = true;
+    }
+    return traversalOrder;
+  }
 
 protected:
   MachineFunction &MF;
@@ -75,9 +111,22 @@ protected:
   const ModuleRaiser *MR;
 
   // A vector of information to be used for raising of control transfer
-  // (i.e., Call and Terminator) instructions.
-  std::vector<ControlTransferInfo *> CTInfo;
+  // (i.e., Call and Terminator) instructions. The records are allocated
+  // using the allocator of the function.
+  SmallVector<ControlTransferInfo *, 8> CTInfo;
 
   bool PrintPass;
+
+  // Opcode of the instruction that failed to raise
+  Optional<unsigned> FailedOpcode;
+
+  void invalidateTraversalOrder() {
+    traversalOrder.clear();
+    traversalOrderValid = false;
+  }
+
+private:
+  LoopTraversal::TraversalOrder traversalOrder;
+  bool traversalOrderValid = false;
 };
 #endif // LLVM_TOOLS_LLVM_MCTOLL_MACHINEINSTRUCTIONRAISER_H
@@ -22,6 +22,9 @@ using namespace llvm;
 using namespace std;
 
 class MachineFunctionRaiser;
+class OpcodeCoverage;
+class PhaseTimes;
+class RaisedCodeMetrics;
 
 using namespace object;
 
@@ -32,7 +35,8 @@ public:
   ModuleRaiser()
       : M(nullptr), TM(nullptr), MMI(nullptr), MIA(nullptr), MII(nullptr),
         Obj(nullptr), DisAsm(nullptr), TextSectionIndex(-1),
-        Arch(Triple::ArchType::UnknownArch), FFT(nullptr), InfoSet(false) {}
+        Arch(Triple::ArchType::UnknownArch), FFT(nullptr), Coverage(nullptr),
+        Metrics(nullptr), Times(nullptr), InfoSet(false) {}
 
   static void InitializeAllModuleRaisers();
 
@@ -79,6 +83,22 @@ public:
   bool collectTextSectionRelocs(const SectionRef &);
   virtual bool collectDynamicRelocations() = 0;
 
+  // Return true if the raiser does not know the kind of instructions with
+  // Opcode.
+  virtual bool isUnknownOpcode(unsigned Opcode) const { return false; }
+
+  // Return true if Inst is an instruction used only to pad the text section
+  // (e.g., for alignment). Such instructions are not raised.
+  virtual bool isPaddingInstruction(const MCInst &Inst) const { return false; }
+
+  // Return true if the function of MFR can be bound to its native code in the
+  // copy of the text section embedded in the raised module. Native code runs
+  // there at an address other than the one it is linked at, so it may not
+  // refer to any address outside the text section.
+  virtual bool canBindToNativeCode(MachineFunctionRaiser &MFR) const {
+    return false;
+  }
+
   MachineFunction *getMachineFunction(Function *);
 
   // Member getters
@@ -91,7 +111,27 @@ public:
   const MCDisassembler *getMCDisassembler() const { return DisAsm; }
   Triple::ArchType getArchType() { return Arch; }
 
-  bool runMachineFunctionPasses();
+  // Raise all functions of the module. The state used to raise each function
+  // is released once it is raised. If ReleaseRaisedFunctions is set, its
+  // machine function and decoded instructions are released as well. If
+  // VerifyRaisedFunctions is set, each function is verified once it is
+  // raised and the module is verified once all functions are raised. If
+  // NativeFallback is set, functions that can not be raised are raised as
+  // thunks to their native code, if their native code can be bound to.
+  // Return false if a function fails to raise or verify and is not bound to
+  // its native code.
+  bool runMachineFunctionPasses(bool ReleaseRaisedFunctions = false,
+                                bool VerifyRaisedFunctions = false,
+                                bool NativeFallback = false);
+
+  // Write the CFG of each function of the module - its blocks, control flow
+  // edges, call sites and jump tables - as JSON to OS, without raising the
+  // functions. Decoded instructions of functions are released once written.
+  void writeCFG(raw_ostream &OS);
+
+  // Merge function fragments split from their functions by the compiler
+  // (e.g., foo.cold) back into the functions.
+  bool mergeSplitFunctionFragments();
 
   // Return the Function * corresponding to input binary function with
   // start offset equal to that specified as argument. This returns the pointer
@@ -109,19 +149,49 @@ public:
   // instruction at index 'I'.
   const RelocationRef *getTextRelocAtOffset(uint64_t I, uint64_t S) const;
 
+  // Return true if Addr is in the range of a data object symbol of the input
+  // binary.
+  bool isDataSymbolAddress(uint64_t Addr) const;
+
   int64_t getTextSectionAddress() const;
 
+  // Return the global at the start of the copy of the text section of the
+  // input binary that functions bound to native code call into.
+  GlobalVariable *getNativeTextGlobal() const;
+
   const Value *getRODataValueAt(uint64_t Offset) const;
 
   void addRODataValueAt(Value *V, uint64_t Offset) const;
 
-  virtual ~ModuleRaiser() {
-    if (FFT != nullptr)
-      delete FFT;
-  }
+  virtual ~ModuleRaiser();
+
   // Get the function filter for current Module.
   FunctionFilter *getFunctionFilter() const { return FFT; }
 
+  // Set the collector of opcode coverage of raised functions. Coverage is
+  // not collected if C is nullptr.
+  void setOpcodeCoverage(OpcodeCoverage *C) { Coverage = C; }
+
+  // Set the collector of metrics of raised functions. Metrics are not
+  // collected if RCM is nullptr.
+  void setRaisedCodeMetrics(RaisedCodeMetrics *RCM) { Metrics = RCM; }
+
+  // Set the timer of phases of raising. Phases are not timed if PT is
+  // nullptr.
+  void setPhaseTimes(PhaseTimes *PT) { Times = PT; }
+
+  // Set the modules raised from the shared libraries the binary depends on.
+  // Functions and variables of the binary defined in these modules are
+  // raised as declarations that resolve to their raised definitions when the
+  // modules are linked.
+  void setLibraryModules(ArrayRef<const Module *> LMs) {
+    LibraryModules.assign(LMs.begin(), LMs.end());
+  }
+
+  // Return the definition of the function or variable named Name in the
+  // modules raised from shared libraries. Return nullptr if none found.
+  const GlobalValue *getLibraryDefinition(StringRef Name) const;
+
 protected:
   // A sequential list of MachineFunctionRaiser objects created
   // as the instructions of the input binary are parsed. Each of
@@ -143,6 +213,14 @@ protected:
   // raising process. Making this map mutable since this map is expected to be
   // updated throughout the raising process.
   mutable std::map<uint64_t, Value *> GlobalRODataValues;
+  // Sorted, disjoint address ranges [Start, End) covered by data object
+  // symbols, built on first use, and the result of looking up each address
+  // looked up.
+  mutable std::vector<std::pair<uint64_t, uint64_t>> DataSymbolRanges;
+  mutable bool DataSymbolRangesBuilt = false;
+  mutable std::map<uint64_t, bool> DataSymbolAddresses;
+  // Modules raised from the shared libraries the binary depends on
+  std::vector<const Module *> LibraryModules;
 
   // Commonly used data structures
   Module *M;
@@ -156,6 +234,9 @@ protected:
   int64_t TextSectionIndex;
   Triple::ArchType Arch;
   FunctionFilter *FFT;
+  OpcodeCoverage *Coverage;
+  RaisedCodeMetrics *Metrics;
+  PhaseTimes *Times;
   // Flag to indicate that fields are set. Resetting is not allowed/expected.
   bool InfoSet;
 };
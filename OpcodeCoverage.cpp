@@ -0,0 +1,162 @@
+//===-- OpcodeCoverage.cpp --------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of OpcodeCoverage class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "OpcodeCoverage.h"
+#include "MachineFunctionRaiser.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <set>
+#include <vector>
+
+void OpcodeCoverage::recordFunction(MachineFunctionRaiser &MFR, bool Raised) {
+  const ModuleRaiser *MR = MFR.getModuleRaiser();
+  const MCInstrInfo *MII = MR->getMCInstrInfo();
+  MCInstRaiser *MCIR = MFR.getMCInstRaiser();
+
+  std::set<unsigned> UnknownOpcodes;
+  for (auto Iter = MCIR->const_mcinstr_begin();
+       Iter != MCIR->const_mcinstr_end(); Iter++) {
+    if (!Iter->second.isMCInst())
+      continue;
+    unsigned Opcode = Iter->second.getMCInst().getOpcode();
+    OpcodeStats &Stats = OpcodeStatsMap[MII->getName(Opcode).str()];
+    Stats.Occurrences++;
+    if (MR->isUnknownOpcode(Opcode)) {
+      Stats.UnknownKind = true;
+      UnknownOpcodes.insert(Opcode);
+    }
+  }
+
+  if (Raised)
+    return;
+
+  uint64_t FuncBytes = 0;
+  for (auto Range : MCIR->getFuncRanges())
+    FuncBytes += Range.second - Range.first;
+
+  // Names of opcodes the failure to raise the function is attributed to
+  std::vector<std::string> Blockers;
+  Optional<unsigned> FailedOpcode =
+      MFR.getMachineInstrRaiser()->getFailedOpcode();
+  if (FailedOpcode.hasValue())
+    Blockers.push_back(MII->getName(FailedOpcode.getValue()).str());
+  else if (MCIR->hasUndecodedInsts())
+    Blockers.push_back("<undecoded>");
+  else
+    for (auto Opcode : UnknownOpcodes)
+      Blockers.push_back(MII->getName(Opcode).str());
+
+  if (Blockers.empty())
+    Blockers.push_back("<unattributed>");
+
+  for (auto &Name : Blockers) {
+    OpcodeStats &Stats = OpcodeStatsMap[Name];
+    Stats.FailedFunctions++;
+    Stats.FailedFunctionBytes += FuncBytes;
+  }
+}
+
+bool OpcodeCoverage::readReport(StringRef ReportFile,
+                                std::map<std::string, OpcodeStats> &Stats) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(ReportFile);
+  if (!BufOrErr) {
+    errs() << "**** Error : Failed to read coverage report " << ReportFile
+           << " : " << BufOrErr.getError().message() << "\n";
+    return false;
+  }
+
+  SmallVector<StringRef, 256> Lines;
+  (*BufOrErr)->getBuffer().split(Lines, '\n', -1, false);
+  for (StringRef Line : Lines) {
+    Line = Line.rtrim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+    SmallVector<StringRef, 5> Fields;
+    Line.split(Fields, '\t');
+    OpcodeStats Read;
+    if ((Fields.size() != 5) || Fields[1].getAsInteger(10, Read.Occurrences) ||
+        Fields[3].getAsInteger(10, Read.FailedFunctions) ||
+        Fields[4].getAsInteger(10, Read.FailedFunctionBytes)) {
+      errs() << "**** Error : Malformed line in coverage report " << ReportFile
+             << " : " << Line << "\n";
+      return false;
+    }
+    OpcodeStats &Merged = Stats[Fields[0].str()];
+    Merged.Occurrences += Read.Occurrences;
+    Merged.UnknownKind |= Fields[2].equals("yes");
+    Merged.FailedFunctions += Read.FailedFunctions;
+    Merged.FailedFunctionBytes += Read.FailedFunctionBytes;
+  }
+  return true;
+}
+
+bool OpcodeCoverage::writeReport(StringRef ReportFile) const {
+  std::map<std::string, OpcodeStats> Stats(OpcodeStatsMap);
+  if (sys::fs::exists(ReportFile) && !readReport(ReportFile, Stats))
+    return false;
+
+  // List opcodes that block the most bytes of functions first, followed by
+  // those that occur most often.
+  std::vector<std::pair<std::string, OpcodeStats>> Entries(Stats.begin(),
+                                                           Stats.end());
+  std::stable_sort(Entries.begin(), Entries.end(),
+                   [](const std::pair<std::string, OpcodeStats> &A,
+                      const std::pair<std::string, OpcodeStats> &B) {
+                     if (A.second.FailedFunctionBytes !=
+                         B.second.FailedFunctionBytes)
+                       return A.second.FailedFunctionBytes >
+                              B.second.FailedFunctionBytes;
+                     return A.second.Occurrences > B.second.Occurrences;
+                   });
+
+  // Write the report to a temporary file that is renamed to ReportFile once
+  // completely written, so that a failed run does not leave a truncated
+  // report behind.
+  Expected<sys::fs::TempFile> Temp =
+      sys::fs::TempFile::create(ReportFile + "-%%%%%%.tmp");
+  if (!Temp) {
+    errs() << "**** Error : Failed to write coverage report " << ReportFile
+           << " : " << toString(Temp.takeError()) << "\n";
+    return false;
+  }
+
+  raw_fd_ostream OS(Temp->FD, /* shouldClose */ false);
+  OS << "# opcode\toccurrences\tunknown-kind\tfailed-functions\t"
+        "failed-function-bytes\n";
+  for (auto &Entry : Entries)
+    OS << Entry.first << "\t" << Entry.second.Occurrences << "\t"
+       << (Entry.second.UnknownKind ? "yes" : "no") << "\t"
+       << Entry.second.FailedFunctions << "\t"
+       << Entry.second.FailedFunctionBytes << "\n";
+  OS.flush();
+
+  Error E = Error::success();
+  if (OS.has_error()) {
+    E = errorCodeToError(OS.error());
+    OS.clear_error();
+    consumeError(Temp->discard());
+  } else
+    E = Temp->keep(ReportFile);
+
+  if (E) {
+    errs() << "**** Error : Failed to write coverage report " << ReportFile
+           << " : " << toString(std::move(E)) << "\n";
+    return false;
+  }
+  return true;
+}
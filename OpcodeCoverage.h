@@ -0,0 +1,59 @@
+//===-- OpcodeCoverage.h ----------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of OpcodeCoverage class for use by
+// llvm-mctoll. This class collects, per opcode, the number of decoded
+// instructions and the functions that failed to raise because of it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_OPCODECOVERAGE_H
+#define LLVM_TOOLS_LLVM_MCTOLL_OPCODECOVERAGE_H
+
+#include "llvm/ADT/StringRef.h"
+#include <map>
+#include <string>
+
+using namespace llvm;
+
+class MachineFunctionRaiser;
+
+class OpcodeCoverage {
+public:
+  // Record the opcodes of the function raised by MFR. If the function was not
+  // raised, attribute its failure to the opcode of the instruction that
+  // failed to raise, if known. Else, attribute it to each opcode of the
+  // function that the raiser does not know.
+  void recordFunction(MachineFunctionRaiser &MFR, bool Raised);
+
+  // Write the report to the file ReportFile. Counts of an existing report in
+  // ReportFile are added to those collected, so that a single report may be
+  // accumulated over a batch of runs. The report is written to a temporary
+  // file that replaces ReportFile, so ReportFile is left unchanged on
+  // failure. Merging is not safe against concurrent runs writing the same
+  // report; the counts of all but one of them may be lost. Return false on
+  // failure.
+  bool writeReport(StringRef ReportFile) const;
+
+private:
+  struct OpcodeStats {
+    uint64_t Occurrences = 0;
+    bool UnknownKind = false;
+    uint64_t FailedFunctions = 0;
+    uint64_t FailedFunctionBytes = 0;
+  };
+
+  // Add stats of an existing report in ReportFile to Stats
+  static bool readReport(StringRef ReportFile,
+                         std::map<std::string, OpcodeStats> &Stats);
+
+  // Map of opcode name -> stats
+  std::map<std::string, OpcodeStats> OpcodeStatsMap;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_OPCODECOVERAGE_H
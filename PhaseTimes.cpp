@@ -0,0 +1,48 @@
+//===-- PhaseTimes.cpp ------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of PhaseTimes class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PhaseTimes.h"
+#include "llvm/Support/Format.h"
+
+void PhaseTimes::start(StringRef Phase) {
+  stop();
+  for (unsigned I = 0, E = Phases.size(); I < E; I++)
+    if (Phases[I].first == Phase) {
+      CurrentPhase = I;
+      break;
+    }
+  if (CurrentPhase < 0) {
+    Phases.emplace_back(Phase.str(), TimeRecord());
+    CurrentPhase = Phases.size() - 1;
+  }
+  StartTime = TimeRecord::getCurrentTime(true);
+}
+
+void PhaseTimes::stop() {
+  if (CurrentPhase < 0)
+    return;
+  TimeRecord Elapsed = TimeRecord::getCurrentTime(false);
+  Elapsed -= StartTime;
+  Phases[CurrentPhase].second += Elapsed;
+  CurrentPhase = -1;
+}
+
+void PhaseTimes::print(raw_ostream &OS) const {
+  OS << "# phase\twall-seconds\tuser-seconds\tsystem-seconds\n";
+  for (const auto &Phase : Phases) {
+    const TimeRecord &Time = Phase.second;
+    OS << Phase.first << "\t" << format("%.6f", Time.getWallTime()) << "\t"
+       << format("%.6f", Time.getUserTime()) << "\t"
+       << format("%.6f", Time.getSystemTime()) << "\n";
+  }
+}
@@ -0,0 +1,47 @@
+//===-- PhaseTimes.h --------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of PhaseTimes class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_PHASETIMES_H
+#define LLVM_TOOLS_LLVM_MCTOLL_PHASETIMES_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Time spent in each phase of raising a binary. At most one phase is timed
+// at a time. Time of a phase that is entered more than once - such as when
+// more than one text section is raised - accumulates.
+class PhaseTimes {
+public:
+  // Stop timing the current phase, if any, and start timing Phase
+  void start(StringRef Phase);
+
+  // Stop timing the current phase, if any
+  void stop();
+
+  // Print the wall, user and system time of each phase, in the order the
+  // phases were first entered, to OS
+  void print(raw_ostream &OS) const;
+
+private:
+  std::vector<std::pair<std::string, TimeRecord>> Phases;
+  // Index in Phases of the phase being timed, or -1 if none
+  int CurrentPhase = -1;
+  TimeRecord StartTime;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_PHASETIMES_H
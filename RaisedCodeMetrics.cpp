@@ -0,0 +1,124 @@
+//===-- RaisedCodeMetrics.cpp -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of RaisedCodeMetrics class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RaisedCodeMetrics.h"
+#include "MachineFunctionRaiser.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/Format.h"
+
+// Return true if Ptr is an address in a stack slot of the function
+static bool isStackAddress(Value *Ptr) {
+  while (true) {
+    Ptr = Ptr->stripPointerCasts();
+    if (auto *GEP = dyn_cast<GEPOperator>(Ptr))
+      Ptr = GEP->getPointerOperand();
+    else
+      return isa<AllocaInst>(Ptr);
+  }
+}
+
+void RaisedCodeMetrics::Counts::add(const Counts &C) {
+  MachineInsts += C.MachineInsts;
+  IRInsts += C.IRInsts;
+  Allocas += C.Allocas;
+  StackLoads += C.StackLoads;
+  StackStores += C.StackStores;
+  Casts += C.Casts;
+  IntToPtrs += C.IntToPtrs;
+  PtrToInts += C.PtrToInts;
+  FlagValues += C.FlagValues;
+}
+
+double RaisedCodeMetrics::Counts::getIRInstsPerMachineInst() const {
+  return (MachineInsts == 0) ? 0.0 : (double)IRInsts / MachineInsts;
+}
+
+void RaisedCodeMetrics::recordFunction(MachineFunctionRaiser &MFR) {
+  Function *F = MFR.getMachineInstrRaiser()->getRaisedFunction();
+  MCInstRaiser *MCIR = MFR.getMCInstRaiser();
+  Counts C;
+
+  for (auto Iter = MCIR->const_mcinstr_begin();
+       Iter != MCIR->const_mcinstr_end(); Iter++)
+    if (Iter->second.isMCInst())
+      C.MachineInsts++;
+
+  for (Instruction &I : instructions(F)) {
+    C.IRInsts++;
+    if (isa<AllocaInst>(I))
+      C.Allocas++;
+    else if (auto *Load = dyn_cast<LoadInst>(&I)) {
+      if (isStackAddress(Load->getPointerOperand()))
+        C.StackLoads++;
+    } else if (auto *Store = dyn_cast<StoreInst>(&I)) {
+      if (isStackAddress(Store->getPointerOperand()))
+        C.StackStores++;
+    } else if (isa<CastInst>(I)) {
+      C.Casts++;
+      if (isa<IntToPtrInst>(I))
+        C.IntToPtrs++;
+      else if (isa<PtrToIntInst>(I))
+        C.PtrToInts++;
+    }
+  }
+  C.FlagValues = MFR.getMachineInstrRaiser()->getNumFlagValues();
+
+  FunctionCounts.emplace_back(F->getName().str(), C);
+  ModuleCounts.add(C);
+}
+
+bool RaisedCodeMetrics::getModuleMetric(StringRef Name, double &Value) const {
+  const Counts &C = ModuleCounts;
+  if (Name == "machine-insts")
+    Value = C.MachineInsts;
+  else if (Name == "ir-insts")
+    Value = C.IRInsts;
+  else if (Name == "ir-per-machine-inst")
+    Value = C.getIRInstsPerMachineInst();
+  else if (Name == "allocas")
+    Value = C.Allocas;
+  else if (Name == "stack-loads")
+    Value = C.StackLoads;
+  else if (Name == "stack-stores")
+    Value = C.StackStores;
+  else if (Name == "casts")
+    Value = C.Casts;
+  else if (Name == "inttoptr")
+    Value = C.IntToPtrs;
+  else if (Name == "ptrtoint")
+    Value = C.PtrToInts;
+  else if (Name == "flag-values")
+    Value = C.FlagValues;
+  else
+    return false;
+  return true;
+}
+
+void RaisedCodeMetrics::printCounts(raw_ostream &OS, StringRef Name,
+                                    const Counts &C) {
+  OS << Name << "\t" << C.MachineInsts << "\t" << C.IRInsts << "\t"
+     << format("%.2f", C.getIRInstsPerMachineInst()) << "\t" << C.Allocas
+     << "\t" << C.StackLoads << "\t" << C.StackStores << "\t" << C.Casts
+     << "\t" << C.IntToPtrs << "\t" << C.PtrToInts << "\t" << C.FlagValues
+     << "\n";
+}
+
+void RaisedCodeMetrics::print(raw_ostream &OS) const {
+  OS << "# function\tmachine-insts\tir-insts\tir-per-machine-inst\tallocas\t"
+        "stack-loads\tstack-stores\tcasts\tinttoptr\tptrtoint\tflag-values\n";
+  for (auto &Entry : FunctionCounts)
+    printCounts(OS, Entry.first, Entry.second);
+  printCounts(OS, "<module>", ModuleCounts);
+}
@@ -0,0 +1,64 @@
+//===-- RaisedCodeMetrics.h -------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of RaisedCodeMetrics class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_RAISEDCODEMETRICS_H
+#define LLVM_TOOLS_LLVM_MCTOLL_RAISEDCODEMETRICS_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+class MachineFunctionRaiser;
+
+// Metrics of the efficiency of raised code, collected per raised function
+// and aggregated over the module. Metrics are measured right after each
+// function is raised, before any optimization of the raised module.
+class RaisedCodeMetrics {
+public:
+  // Record metrics of the function raised by MFR. Raiser state of MFR is
+  // expected to be not yet released.
+  void recordFunction(MachineFunctionRaiser &MFR);
+
+  // Print metrics of each function followed by those of the module to OS
+  void print(raw_ostream &OS) const;
+
+  // Return the metric named Name of the module in Value. Return false if
+  // Name is not a known metric.
+  bool getModuleMetric(StringRef Name, double &Value) const;
+
+private:
+  struct Counts {
+    uint64_t MachineInsts = 0;
+    uint64_t IRInsts = 0;
+    uint64_t Allocas = 0;
+    uint64_t StackLoads = 0;
+    uint64_t StackStores = 0;
+    uint64_t Casts = 0;
+    uint64_t IntToPtrs = 0;
+    uint64_t PtrToInts = 0;
+    uint64_t FlagValues = 0;
+
+    void add(const Counts &C);
+    double getIRInstsPerMachineInst() const;
+  };
+
+  static void printCounts(raw_ostream &OS, StringRef Name, const Counts &C);
+
+  std::vector<std::pair<std::string, Counts>> FunctionCounts;
+  Counts ModuleCounts;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_RAISEDCODEMETRICS_H
@@ -0,0 +1,65 @@
+//===-- RaisedModuleRunner.cpp ----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of the function that runs a raised
+// module in process for use by llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RaisedModuleRunner.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+
+using namespace llvm::orc;
+
+Expected<int> runRaisedModule(const Module &M, StringRef ProgramName,
+                              ArrayRef<std::string> Args) {
+  // Code is generated for the host
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+
+  // LLJIT takes ownership of the modules it compiles along with their
+  // context. The context of M is shared with other raised modules. So a copy
+  // of M in a context of its own is made, through bitcode.
+  SmallVector<char, 0> Bitcode;
+  raw_svector_ostream BitcodeOS(Bitcode);
+  WriteBitcodeToFile(M, BitcodeOS);
+  auto Ctx = std::make_unique<LLVMContext>();
+  Expected<std::unique_ptr<Module>> JITModule = parseBitcodeFile(
+      MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()),
+                      M.getModuleIdentifier()),
+      *Ctx);
+  if (!JITModule)
+    return JITModule.takeError();
+
+  Expected<std::unique_ptr<LLJIT>> J = LLJITBuilder().create();
+  if (!J)
+    return J.takeError();
+
+  Expected<std::unique_ptr<DynamicLibrarySearchGenerator>> ProcessSymbols =
+      DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          (*J)->getDataLayout().getGlobalPrefix());
+  if (!ProcessSymbols)
+    return ProcessSymbols.takeError();
+  (*J)->getMainJITDylib().addGenerator(std::move(*ProcessSymbols));
+
+  if (Error Err = (*J)->addIRModule(
+          ThreadSafeModule(std::move(*JITModule), std::move(Ctx))))
+    return std::move(Err);
+
+  Expected<JITEvaluatedSymbol> MainSym = (*J)->lookup("main");
+  if (!MainSym)
+    return MainSym.takeError();
+  using MainFnTy = int (*)(int, char *[]);
+  return runAsMain(jitTargetAddressToFunction<MainFnTy>(MainSym->getAddress()),
+                   Args, ProgramName);
+}
@@ -0,0 +1,32 @@
+//===-- RaisedModuleRunner.h ------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of the function that runs a raised
+// module in process for use by llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_RAISEDMODULERUNNER_H
+#define LLVM_TOOLS_LLVM_MCTOLL_RAISEDMODULERUNNER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Error.h"
+#include <string>
+
+using namespace llvm;
+
+// Compile raised module M with ORC LLJIT and run its main function in this
+// process, with ProgramName and Args as its arguments. Symbols M does not
+// define, such as those of libc, are resolved against those of this process.
+// Return the value main returns.
+Expected<int> runRaisedModule(const Module &M, StringRef ProgramName,
+                              ArrayRef<std::string> Args);
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_RAISEDMODULERUNNER_H
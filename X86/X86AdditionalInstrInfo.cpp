@@ -513,14 +513,14 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::CMPSSrr_Int, {0, Unknown}},
     {X86::CMPSW, {0, Unknown}},
     {X86::CMPXCHG16B, {0, Unknown}},
-    {X86::CMPXCHG16rm, {2, Unknown}},
+    {X86::CMPXCHG16rm, {2, ATOMIC_MEM_OP}},
     {X86::CMPXCHG16rr, {0, Unknown}},
-    {X86::CMPXCHG32rm, {4, Unknown}},
+    {X86::CMPXCHG32rm, {4, ATOMIC_MEM_OP}},
     {X86::CMPXCHG32rr, {0, Unknown}},
-    {X86::CMPXCHG64rm, {8, Unknown}},
+    {X86::CMPXCHG64rm, {8, ATOMIC_MEM_OP}},
     {X86::CMPXCHG64rr, {0, Unknown}},
     {X86::CMPXCHG8B, {0, Unknown}},
-    {X86::CMPXCHG8rm, {1, Unknown}},
+    {X86::CMPXCHG8rm, {1, ATOMIC_MEM_OP}},
     {X86::CMPXCHG8rr, {0, Unknown}},
     {X86::COMISDrm, {0, Unknown}},
     {X86::COMISDrm_Int, {0, Unknown}},
@@ -1149,7 +1149,7 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::LEAVE64, {0, LEAVE_OP}},
     {X86::LES16rm, {2, Unknown}},
     {X86::LES32rm, {4, Unknown}},
-    {X86::LFENCE, {0, Unknown}},
+    {X86::LFENCE, {0, FENCE}},
     {X86::LFS16rm, {2, Unknown}},
     {X86::LFS32rm, {4, Unknown}},
     {X86::LFS64rm, {8, Unknown}},
@@ -1213,7 +1213,7 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::LOCK_OR64mr, {8, Unknown}},
     {X86::LOCK_OR8mi, {1, Unknown}},
     {X86::LOCK_OR8mr, {1, Unknown}},
-    {X86::LOCK_PREFIX, {0, Unknown}},
+    {X86::LOCK_PREFIX, {0, NOOP}},
     {X86::LOCK_SUB16mi, {2, Unknown}},
     {X86::LOCK_SUB16mi8, {2, Unknown}},
     {X86::LOCK_SUB16mr, {2, Unknown}},
@@ -1300,7 +1300,7 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::MAXSSrm_Int, {0, Unknown}},
     {X86::MAXSSrr, {0, Unknown}},
     {X86::MAXSSrr_Int, {0, Unknown}},
-    {X86::MFENCE, {0, Unknown}},
+    {X86::MFENCE, {0, FENCE}},
     {X86::MINCPDrm, {0, Unknown}},
     {X86::MINCPDrr, {0, Unknown}},
     {X86::MINCPSrm, {0, Unknown}},
@@ -2445,7 +2445,7 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::SEH_StackAlloc, {0, Unknown}},
     {X86::SETCCr, {0, SETCC}},
     {X86::SETCCm, {0, SETCC}},
-    {X86::SFENCE, {0, Unknown}},
+    {X86::SFENCE, {0, FENCE}},
     {X86::SGDT16m, {0, Unknown}},
     {X86::SGDT32m, {0, Unknown}},
     {X86::SGDT64m, {0, Unknown}},
@@ -14055,27 +14055,27 @@ static constexpr const_addl_instr_info::value_type mapdata[] = {
     {X86::XABORT, {0, Unknown}},
     {X86::XABORT_DEF, {0, Unknown}},
     {X86::XACQUIRE_PREFIX, {0, Unknown}},
-    {X86::XADD16rm, {2, Unknown}},
+    {X86::XADD16rm, {2, ATOMIC_MEM_OP}},
     {X86::XADD16rr, {0, Unknown}},
-    {X86::XADD32rm, {4, Unknown}},
+    {X86::XADD32rm, {4, ATOMIC_MEM_OP}},
     {X86::XADD32rr, {0, Unknown}},
-    {X86::XADD64rm, {8, Unknown}},
+    {X86::XADD64rm, {8, ATOMIC_MEM_OP}},
     {X86::XADD64rr, {0, Unknown}},
-    {X86::XADD8rm, {1, Unknown}},
+    {X86::XADD8rm, {1, ATOMIC_MEM_OP}},
     {X86::XADD8rr, {0, Unknown}},
     {X86::XBEGIN, {0, Unknown}},
     {X86::XBEGIN_2, {0, Unknown}},
     {X86::XBEGIN_4, {0, Unknown}},
     {X86::XCHG16ar, {0, Unknown}},
-    {X86::XCHG16rm, {2, Unknown}},
+    {X86::XCHG16rm, {2, ATOMIC_MEM_OP}},
     {X86::XCHG16rr, {0, Unknown}},
     {X86::XCHG32ar, {0, Unknown}},
-    {X86::XCHG32rm, {4, Unknown}},
+    {X86::XCHG32rm, {4, ATOMIC_MEM_OP}},
     {X86::XCHG32rr, {0, Unknown}},
     {X86::XCHG64ar, {0, Unknown}},
-    {X86::XCHG64rm, {8, Unknown}},
+    {X86::XCHG64rm, {8, ATOMIC_MEM_OP}},
     {X86::XCHG64rr, {0, Unknown}},
-    {X86::XCHG8rm, {1, Unknown}},
+    {X86::XCHG8rm, {1, ATOMIC_MEM_OP}},
     {X86::XCHG8rr, {0, Unknown}},
     {X86::XCH_F, {0, Unknown}},
     {X86::XCRYPTCBC, {0, Unknown}},
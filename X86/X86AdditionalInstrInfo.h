@@ -23,6 +23,7 @@ namespace mctoll {
 // Instruction Kinds
 enum InstructionKind : uint8_t {
   Unknown = 0,
+  ATOMIC_MEM_OP, // implicitly locked memory operations (xchg, xadd, cmpxchg)
   BINARY_OP_RM,
   BINARY_OP_RR,
   BINARY_OP_WITH_IMM,
@@ -33,6 +34,7 @@ enum InstructionKind : uint8_t {
   CONVERT_WDDQQO,
   DIVIDE_MEM_OP,
   DIVIDE_REG_OP,
+  FENCE,
   FPU_REG_OP,
   LEA_OP,
   LEAVE_OP,
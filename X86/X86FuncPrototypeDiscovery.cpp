@@ -17,6 +17,7 @@
 #include "X86MachineInstructionRaiser.h"
 #include "X86ModuleRaiser.h"
 #include "X86RaisedValueTracker.h"
+#include "X86RegisterLiveness.h"
 #include "X86RegisterUtils.h"
 #include "llvm-mctoll.h"
 #include "llvm/ADT/DepthFirstIterator.h"
@@ -58,37 +59,8 @@ static bool hasExactImplicitDefOfPhysReg(const MachineInstr &I, unsigned Reg,
 // register PReg according to C calling convention.
 
 int X86MachineInstructionRaiser::getArgumentNumber(unsigned PReg) {
-  int pos = -1;
-  if (is8BitPhysReg(PReg)) {
-    int diff = std::distance(
-        GPR64ArgRegs8Bit.begin(),
-        std::find(GPR64ArgRegs8Bit.begin(), GPR64ArgRegs8Bit.end(), PReg));
-    if ((diff >= 0) && (diff < (int)GPR64ArgRegs8Bit.size())) {
-      pos = diff + 1;
-    }
-  } else if (is16BitPhysReg(PReg)) {
-    int diff = std::distance(
-        GPR64ArgRegs16Bit.begin(),
-        std::find(GPR64ArgRegs16Bit.begin(), GPR64ArgRegs16Bit.end(), PReg));
-    if ((diff >= 0) && (diff < (int)GPR64ArgRegs16Bit.size())) {
-      pos = diff + 1;
-    }
-  } else if (is32BitPhysReg(PReg)) {
-    int diff = std::distance(
-        GPR64ArgRegs32Bit.begin(),
-        std::find(GPR64ArgRegs32Bit.begin(), GPR64ArgRegs32Bit.end(), PReg));
-    if ((diff >= 0) && (diff < (int)GPR64ArgRegs32Bit.size())) {
-      pos = diff + 1;
-    }
-  } else if (is64BitPhysReg(PReg)) {
-    int diff = std::distance(
-        GPR64ArgRegs64Bit.begin(),
-        std::find(GPR64ArgRegs64Bit.begin(), GPR64ArgRegs64Bit.end(), PReg));
-    if ((diff >= 0) && (diff < (int)GPR64ArgRegs64Bit.size())) {
-      pos = diff + 1;
-    }
-  }
-  return pos;
+  int ArgNumber = getPhysRegInfo(PReg).ArgNumber;
+  return (ArgNumber == 0) ? -1 : ArgNumber;
 }
 
 // Add Reg to LiveInSet. This function adds the actual register Reg - not its
@@ -97,6 +69,13 @@ int X86MachineInstructionRaiser::getArgumentNumber(unsigned PReg) {
 void X86MachineInstructionRaiser::addRegisterToFunctionLiveInSet(
     MCPhysRegSet &LiveInSet, unsigned Reg) {
 
+  // A register that is not live-in at function entry can not be an argument.
+  // Note that the liveness computed is conservative.
+  X86RegisterLiveness *RegLiveness = getRegisterLiveness();
+  if (RegLiveness->isTrackedReg(Reg) &&
+      !RegLiveness->isLiveIn(Reg, MF.front().getNumber()))
+    return;
+
   // Nothing to do if Reg is already in the set.
   if (LiveInSet.find(Reg) != LiveInSet.end())
     return;
@@ -234,9 +213,8 @@ FunctionType *X86MachineInstructionRaiser::getRaisedFunctionPrototype() {
   if (raisedFunction != nullptr)
     return raisedFunction->getFunctionType();
 
-  // Cleanup NOOP instructions from all MachineBasicBlocks
-  deleteNOOPInstrMF();
-  // Clean up any empty basic blocks
+  // Clean up any empty basic blocks. Padding instructions are not raised to
+  // MachineInstrs while building the CFG. So this is only a safety net.
   unlinkEmptyMBBs();
 
   MF.getRegInfo().freezeReservedRegs(MF);
@@ -257,9 +235,8 @@ FunctionType *X86MachineInstructionRaiser::getRaisedFunctionPrototype() {
   MCPhysRegSizeMap MBBDefRegs;
 
   // Walk the CFG DFS to discover first register usage
-  LoopTraversal Traversal;
-  LoopTraversal::TraversalOrder TraversedMBBOrder = Traversal.traverse(MF);
-  for (LoopTraversal::TraversedMBBInfo TraversedMBB : TraversedMBBOrder) {
+  for (const LoopTraversal::TraversedMBBInfo &TraversedMBB :
+       getTraversalOrder()) {
     MachineBasicBlock *MBB = TraversedMBB.MBB;
     if (MBB->empty())
       continue;
@@ -352,34 +329,7 @@ FunctionType *X86MachineInstructionRaiser::getRaisedFunctionPrototype() {
             getPhysRegSizeInBits(DestReg) / 8;
       } else if (MI.isCall() || MI.isUnconditionalBranch()) {
         // If this is an unconditional branch, check if it is a tail call.
-        if (MI.isUnconditionalBranch()) {
-          if ((MI.getNumOperands() > 0) && MI.getOperand(0).isImm()) {
-            // Only if this is a direct branch instruction with an
-            // immediate offset
-            const MCInstrDesc MCID = MI.getDesc();
-            if (X86II::isImmPCRel(MCID.TSFlags)) {
-              // Get branch offset of the branch instruction
-              const MachineOperand &MO = MI.getOperand(0);
-              assert(MO.isImm() && "Expected immediate operand not found");
-              int64_t BranchOffset = MO.getImm();
-              MCInstRaiser *MCIR = getMCInstRaiser();
-              assert(MCIR != nullptr && "MCInstRaiser not initialized");
-
-              // Get the (MCInst) offset of the instruction in the binary
-              uint64_t MCInstOffset = MCIR->getMCInstIndex(MI);
-              int64_t BranchTargetOffset = MCInstOffset +
-                                           MCIR->getMCInstSize(MCInstOffset) +
-                                           BranchOffset;
-              // This may be a tail call if there is no MBB corresponding to the
-              // branch target offset.
-              if (MCIR->getMBBNumberOfMCInstOffset(BranchTargetOffset) == -1) {
-                // It is a tail call only if there are no other instructions
-                // after this unconditional branch instruction.
-                IsTailCall = (MI.getNextNode() == nullptr);
-              }
-            }
-          }
-        }
+        IsTailCall = isDirectTailCall(MI);
 
         // If the instruction is a call or a potential tail call,
         // attempt to find the called function.
@@ -0,0 +1,41 @@
+//===-- X86InstrSemantics.cpp -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the table of semantics of X86 instructions that are
+// raised as a single LLVM IR binary operation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86InstrSemantics.h"
+#include "llvm/ADT/DenseMap.h"
+#include <X86InstrBuilder.h>
+#include <X86Subtarget.h>
+
+using namespace llvm;
+
+namespace mctoll {
+
+static const std::pair<uint16_t, X86InstrSemantics> SemanticsData[] = {
+#define X86_INSTR_SEMANTICS(Opcode, BinOp, ImplicitSrc2, TestedFlags,          \
+                            ClearedFlags)                                      \
+  {X86::Opcode,                                                                \
+   {Instruction::BinOp, ImplicitSrc2, TestedFlags, ClearedFlags}},
+#include "X86InstrSemantics.def"
+};
+
+static const DenseMap<uint16_t, X86InstrSemantics>
+    X86InstrSemanticsTable(std::begin(SemanticsData), std::end(SemanticsData));
+
+const X86InstrSemantics *getInstrSemantics(unsigned int Opcode) {
+  auto Iter = X86InstrSemanticsTable.find((uint16_t)Opcode);
+  if (Iter == X86InstrSemanticsTable.end())
+    return nullptr;
+  return &Iter->second;
+}
+
+} // namespace mctoll
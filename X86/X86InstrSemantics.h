@@ -0,0 +1,47 @@
+//===-- X86InstrSemantics.h -------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of the table of semantics of X86
+// instructions that are raised as a single LLVM IR binary operation. The
+// table is populated from X86InstrSemantics.def.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_X86_X86INSTRSEMANTICS_H
+#define LLVM_TOOLS_LLVM_MCTOLL_X86_X86INSTRSEMANTICS_H
+
+#include "llvm/IR/Instruction.h"
+#include <cstdint>
+
+namespace mctoll {
+
+// Status flags of EFLAGS that an instruction affects
+enum X86InstrFlagEffect : uint8_t {
+  FLAG_CF = 1 << 0,
+  FLAG_ZF = 1 << 1,
+  FLAG_SF = 1 << 2,
+  FLAG_OF = 1 << 3,
+};
+
+struct X86InstrSemantics {
+  // Binary operator computing the result
+  llvm::Instruction::BinaryOps BinOp;
+  // Value of second source operand encoded in the opcode; 0 if none.
+  uint8_t ImplicitSrc2;
+  // Status flags set according to the result
+  uint8_t TestedFlags;
+  // Status flags cleared
+  uint8_t ClearedFlags;
+};
+
+// Return the semantics of Opcode, or nullptr if Opcode is not in the table.
+const X86InstrSemantics *getInstrSemantics(unsigned int Opcode);
+
+} // namespace mctoll
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_X86_X86INSTRSEMANTICS_H
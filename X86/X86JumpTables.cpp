@@ -26,230 +26,218 @@
 using namespace llvm;
 using namespace mctoll;
 
-bool X86MachineInstructionRaiser::raiseMachineJumpTable() {
-  // A vector to record MBBS that need be erased upon jump table creation.
-  std::vector<MachineBasicBlock *> MBBsToBeErased;
+// Return the targets of the jump table whose base is computed by MI, if MI
+// computes the base of a jump table through which the block of MI branches.
+// Return an empty vector otherwise. MF is not modified.
+std::vector<MachineBasicBlock *>
+X86MachineInstructionRaiser::getJumpTableTargets(MachineInstr &MI) {
+  // A vector of switch target MBBs
+  std::vector<MachineBasicBlock *> JmpTgtMBBvec;
+  // Jump table contents are read from the sections of 64-bit ELF binaries.
+  const ELF64LEObjectFile *Elf64LEObjFile =
+      dyn_cast<ELF64LEObjectFile>(MR->getObjectFile());
+  if (Elf64LEObjFile == nullptr)
+    return JmpTgtMBBvec;
 
   // Address of text section.
   int64_t TextSectionAddress = MR->getTextSectionAddress();
   MCInstRaiser *MCIR = getMCInstRaiser();
+  MachineBasicBlock &JmpTblBaseCalcMBB = *MI.getParent();
+  unsigned Opcode = MI.getOpcode();
+  auto InstKind = getInstructionKind(Opcode);
+  // Physical destination register with the computed jump table base value.
+  unsigned int JmpTblBaseReg = X86::NoRegister;
+  // Find the MI LEA64r $rip and save offset of rip
+  // This is typically generated in a shared library.
+  if (Opcode == X86::LEA64r && MI.getOperand(1).getReg() == X86::RIP &&
+      MI.getOperand(4).isImm()) {
+    uint32_t JmpOffset = MI.getOperand(4).getImm();
+    auto MCInstIndex = MCIR->getMCInstIndex(MI);
+    uint64_t MCInstSz = MCIR->getMCInstSize(MCInstIndex);
+    // Calculate memory offset of the referenced offset.
+    uint32_t JmpTblBaseMemAddress =
+        TextSectionAddress + MCInstIndex + MCInstSz + JmpOffset;
+    JmpTblBaseReg = MI.getOperand(0).getReg();
+    const unsigned char *DataContent = nullptr;
+    size_t DataSize = 0;
+    size_t JmpTblEntryOffset = 0;
+    // Find the section.
+    for (section_iterator SecIter : Elf64LEObjFile->sections()) {
+      uint64_t SecStart = SecIter->getAddress();
+      uint64_t SecEnd = SecStart + SecIter->getSize();
+      if ((SecStart <= JmpTblBaseMemAddress) &&
+          (SecEnd >= JmpTblBaseMemAddress)) {
+        StringRef Contents = unwrapOrError(SecIter->getContents(),
+                                           MR->getObjectFile()->getFileName());
+        DataContent =
+            static_cast<const unsigned char *>(Contents.bytes_begin());
+        DataSize = SecIter->getSize();
+        JmpTblEntryOffset = JmpTblBaseMemAddress - SecStart;
 
-  // Get the MIs which potentially load the jumptable base address.
-  for (MachineBasicBlock &JmpTblBaseCalcMBB : MF) {
-    for (MachineBasicBlock::iterator CurMBBIter = JmpTblBaseCalcMBB.begin();
-         CurMBBIter != JmpTblBaseCalcMBB.end(); CurMBBIter++) {
-      MachineInstr &JmpTblOffsetCalcMI = (*CurMBBIter);
-      unsigned Opcode = JmpTblOffsetCalcMI.getOpcode();
-      auto InstKind = getInstructionKind(Opcode);
-      // A vector of switch target MBBs
-      std::vector<MachineBasicBlock *> JmpTgtMBBvec;
-      // Physical destination register with the computed jump table base value.
-      unsigned int JmpTblBaseReg = X86::NoRegister;
-      // Find the MI LEA64r $rip and save offset of rip
-      // This is typically generated in a shared library.
-      if (Opcode == X86::LEA64r &&
-          JmpTblOffsetCalcMI.getOperand(1).getReg() == X86::RIP &&
-          JmpTblOffsetCalcMI.getOperand(4).isImm()) {
-        uint32_t JmpOffset = JmpTblOffsetCalcMI.getOperand(4).getImm();
-        auto MCInstIndex = MCIR->getMCInstIndex(JmpTblOffsetCalcMI);
-        uint64_t MCInstSz = MCIR->getMCInstSize(MCInstIndex);
-        // Calculate memory offset of the referenced offset.
-        uint32_t JmpTblBaseMemAddress =
-            TextSectionAddress + MCInstIndex + MCInstSz + JmpOffset;
-        JmpTblBaseReg = JmpTblOffsetCalcMI.getOperand(0).getReg();
-        // Get the contents of the section with JmpTblBaseMemAddress
-        const ELF64LEObjectFile *Elf64LEObjFile =
-            dyn_cast<ELF64LEObjectFile>(MR->getObjectFile());
-        assert(Elf64LEObjFile != nullptr &&
-               "Only 64-bit ELF binaries supported at present.");
-        const unsigned char *DataContent = nullptr;
-        size_t DataSize = 0;
-        size_t JmpTblEntryOffset = 0;
-        // Find the section.
-        for (section_iterator SecIter : Elf64LEObjFile->sections()) {
-          uint64_t SecStart = SecIter->getAddress();
-          uint64_t SecEnd = SecStart + SecIter->getSize();
-          if ((SecStart <= JmpTblBaseMemAddress) &&
-              (SecEnd >= JmpTblBaseMemAddress)) {
-            StringRef Contents = unwrapOrError(
-                SecIter->getContents(), MR->getObjectFile()->getFileName());
-            DataContent =
-                static_cast<const unsigned char *>(Contents.bytes_begin());
-            DataSize = SecIter->getSize();
-            JmpTblEntryOffset = JmpTblBaseMemAddress - SecStart;
-
-            break;
-          }
-        }
+        break;
+      }
+    }
 
-        // Section with jump table base has no content.
-        if (DataSize == 0)
-          // Continue looking for MIs which potentially load a jumptable base
-          // address.
-          continue;
-
-        while (JmpTblEntryOffset < DataSize) {
-          // Get the 32-bit value at JmpTblEntryOffset in section data content.
-          // This provides the offset value from JmpTblBaseMemAddress of the
-          // corresponding jump table target. Add this offset to
-          // JmpTblBaseMemAddress to get section address of jump target.
-
-          uint32_t JmpTgtMemAddr = *(reinterpret_cast<const uint32_t *>(
-                                       DataContent + JmpTblEntryOffset)) +
-                                   JmpTblBaseMemAddress;
-
-          // Get MBB corresponding to offset into text section of JmpTgtMemAddr
-          auto MBBNo = MCIR->getMBBNumberOfMCInstOffset(JmpTgtMemAddr -
-                                                        TextSectionAddress);
-
-          // Continue reading 4-byte offsets from the section contents till
-          // there is no valid MBB corresponding to jump target offset or
-          // section end is reached.
-          if (MBBNo == -1)
-            break;
-
-          MachineBasicBlock *MBB = MF.getBlockNumbered(MBBNo);
-          JmpTgtMBBvec.push_back(MBB);
-          // Attempt to get the next table entry value. Assuming that each
-          // table entry is 4 bytes long. Stop before attempting to read past
-          // Section data size.
-          JmpTblEntryOffset += 4;
-        }
+    // Section with jump table base has no content.
+    if (DataSize == 0)
+      return JmpTgtMBBvec;
+
+    while (JmpTblEntryOffset + 4 <= DataSize) {
+      // Get the 32-bit value at JmpTblEntryOffset in section data content.
+      // This provides the offset value from JmpTblBaseMemAddress of the
+      // corresponding jump table target. Add this offset to
+      // JmpTblBaseMemAddress to get section address of jump target.
+
+      uint32_t JmpTgtMemAddr = *(reinterpret_cast<const uint32_t *>(
+                                   DataContent + JmpTblEntryOffset)) +
+                               JmpTblBaseMemAddress;
+
+      // Get MBB corresponding to offset into text section of JmpTgtMemAddr
+      auto MBBNo =
+          MCIR->getMBBNumberOfMCInstOffset(JmpTgtMemAddr - TextSectionAddress);
+
+      // Continue reading 4-byte offsets from the section contents till
+      // there is no valid MBB corresponding to jump target offset or
+      // section end is reached.
+      if (MBBNo == -1)
+        break;
+
+      MachineBasicBlock *MBB = MF.getBlockNumbered(MBBNo);
+      JmpTgtMBBvec.push_back(MBB);
+      // Attempt to get the next table entry value. Assuming that each
+      // table entry is 4 bytes long. Stop before attempting to read past
+      // Section data size.
+      JmpTblEntryOffset += 4;
+    }
+  }
+  // mov instruction of the kind mov offset(, IndxReg, Scale), Reg
+  else if ((InstKind == InstructionKind::MOV_FROM_MEM) ||
+           (InstKind == InstructionKind::BRANCH_MEM_OP)) {
+    // Get index of memory reference in the instruction.
+    int memoryRefOpIndex = getMemoryRefOpIndex(MI);
+    assert((memoryRefOpIndex >= 0) && "Unexpected memory operand index");
+    X86AddressMode memRef = llvm::getAddressFromInstr(&MI, memoryRefOpIndex);
+    if (memRef.Base.Reg != X86::NoRegister)
+      return JmpTgtMBBvec;
+    unsigned memReadTargetByteSz = getInstructionMemOpSize(Opcode);
+    assert(memReadTargetByteSz > 0 &&
+           "Incorrect memory access size of instruction");
+    int JmpTblBaseAddress = memRef.Disp;
+    if (JmpTblBaseAddress <= 0)
+      return JmpTgtMBBvec;
+    // This value should be an absolute offset into a rodata section.
+    // Get the contents of the section with JmpTblBase
+    StringRef Contents;
+    JmpTblBaseReg = MI.getOperand(0).getReg();
+    size_t DataSize = 0;
+    size_t JmpTblBaseOffset = 0;
+    // Find the section.
+    for (section_iterator SecIter : Elf64LEObjFile->sections()) {
+      uint64_t SecStart = SecIter->getAddress();
+      uint64_t SecEnd = SecStart + SecIter->getSize();
+      // Potential JmpTblBase is in a data section
+      // OK to cast to unsigned as JmpTblBase is > 0 at this point.
+      if ((SecStart <= (unsigned)JmpTblBaseAddress) &&
+          (SecEnd >= (unsigned)JmpTblBaseAddress) && SecIter->isData()) {
+        Contents = unwrapOrError(SecIter->getContents(),
+                                 MR->getObjectFile()->getFileName());
+        DataSize = SecIter->getSize();
+        JmpTblBaseOffset = JmpTblBaseAddress - SecStart;
+        break;
       }
-      // mov instruction of the kind mov offset(, IndxReg, Scale), Reg
-      else {
-        // Get index of memory reference in the instruction.
-        int memoryRefOpIndex = getMemoryRefOpIndex(JmpTblOffsetCalcMI);
-        if ((InstKind == InstructionKind::MOV_FROM_MEM) ||
-            (InstKind == InstructionKind::BRANCH_MEM_OP)) {
-          assert((memoryRefOpIndex >= 0) && "Unexpected memory operand index");
-          X86AddressMode memRef =
-              llvm::getAddressFromInstr(&JmpTblOffsetCalcMI, memoryRefOpIndex);
-          if (memRef.Base.Reg == X86::NoRegister) {
-            unsigned memReadTargetByteSz = getInstructionMemOpSize(Opcode);
-            assert(memReadTargetByteSz > 0 &&
-                   "Incorrect memory access size of instruction");
-            int JmpTblBaseAddress = memRef.Disp;
-            if (JmpTblBaseAddress > 0) {
-              // This value should be an absolute offset into a rodata section.
-              // Get the contents of the section with JmpTblBase
-              const ELF64LEObjectFile *Elf64LEObjFile =
-                  dyn_cast<ELF64LEObjectFile>(MR->getObjectFile());
-              assert(Elf64LEObjFile != nullptr &&
-                     "Only 64-bit ELF binaries supported at present.");
-              StringRef Contents;
-              JmpTblBaseReg = JmpTblOffsetCalcMI.getOperand(0).getReg();
-              size_t DataSize = 0;
-              size_t JmpTblBaseOffset = 0;
-              // Find the section.
-              for (section_iterator SecIter : Elf64LEObjFile->sections()) {
-                uint64_t SecStart = SecIter->getAddress();
-                uint64_t SecEnd = SecStart + SecIter->getSize();
-                // Potential JmpTblBase is in a data section
-                // OK to cast to unsigned as JmpTblBase is > 0 at this point.
-                if ((SecStart <= (unsigned)JmpTblBaseAddress) &&
-                    (SecEnd >= (unsigned)JmpTblBaseAddress) &&
-                    SecIter->isData()) {
-                  Contents = unwrapOrError(SecIter->getContents(),
-                                           MR->getObjectFile()->getFileName());
-                  DataSize = SecIter->getSize();
-                  JmpTblBaseOffset = JmpTblBaseAddress - SecStart;
-                  break;
-                }
-              }
-
-              // Section with jump table base has no content.
-              if (DataSize == 0)
-                // Continue looking for MIs which potentially load a jumptable
-                // base address.
-                continue;
-
-              BinaryByteStream SectionContent(
-                  Contents, llvm::support::endianness::little);
-              size_t CurReadByteOffset = JmpTblBaseOffset;
-
-              while (CurReadByteOffset < DataSize) {
-                ArrayRef<uint8_t> v(memReadTargetByteSz);
-
-                if (CurReadByteOffset + memReadTargetByteSz > DataSize)
-                  break;
-
-                Error EC = SectionContent.readBytes(CurReadByteOffset,
-                                                    memReadTargetByteSz, v);
-                // Eat the error; the section does not have jumptable data
-                if (EC) {
-                  handleAllErrors(std::move(EC),
-                                  [&](const ErrorInfoBase &EI) {});
-                  break;
-                }
-
-                uint64_t JmpTgtMemAddr =
-                    llvm::support::endian::read64le(v.data());
-                // get MBB corresponding to file offset into text section of
-                // JmpTgtMemAddr
-                auto MBBNo = MCIR->getMBBNumberOfMCInstOffset(
-                    JmpTgtMemAddr - TextSectionAddress);
-                if (MBBNo != -1) {
-                  MachineBasicBlock *MBB = MF.getBlockNumbered(MBBNo);
-                  JmpTgtMBBvec.push_back(MBB);
-                } else {
-                  // Jump table entries are expected to be in a sequence. Once
-                  // data that is different from a jump table entry is detected,
-                  // stop looking for table entries.
-                  break;
-                }
-                CurReadByteOffset += memReadTargetByteSz;
-              }
-            }
-          }
-        }
+    }
+
+    // Section with jump table base has no content.
+    if (DataSize == 0)
+      return JmpTgtMBBvec;
+
+    BinaryByteStream SectionContent(Contents,
+                                    llvm::support::endianness::little);
+    size_t CurReadByteOffset = JmpTblBaseOffset;
+
+    while (CurReadByteOffset < DataSize) {
+      ArrayRef<uint8_t> v(memReadTargetByteSz);
+
+      if (CurReadByteOffset + memReadTargetByteSz > DataSize)
+        break;
+
+      Error EC =
+          SectionContent.readBytes(CurReadByteOffset, memReadTargetByteSz, v);
+      // Eat the error; the section does not have jumptable data
+      if (EC) {
+        handleAllErrors(std::move(EC), [&](const ErrorInfoBase &EI) {});
+        break;
       }
 
-      // If no potential jump target addresses were found the current
-      // instruction does not compute jump table base.
-      if (JmpTgtMBBvec.size() == 0) {
-        continue;
+      uint64_t JmpTgtMemAddr = llvm::support::endian::read64le(v.data());
+      // get MBB corresponding to file offset into text section of
+      // JmpTgtMemAddr
+      auto MBBNo =
+          MCIR->getMBBNumberOfMCInstOffset(JmpTgtMemAddr - TextSectionAddress);
+      if (MBBNo != -1) {
+        MachineBasicBlock *MBB = MF.getBlockNumbered(MBBNo);
+        JmpTgtMBBvec.push_back(MBB);
+      } else {
+        // Jump table entries are expected to be in a sequence. Once
+        // data that is different from a jump table entry is detected,
+        // stop looking for table entries.
+        break;
       }
+      CurReadByteOffset += memReadTargetByteSz;
+    }
+  }
 
-      // Check to verify the current  block - JmpTblBaseCalcMBB - terminates
-      // with an indirect branch.
-      bool BuildJumpTable = true;
-      for (auto &T : JmpTblBaseCalcMBB.terminators()) {
-        if (!T.isIndirectBranch()) {
-          BuildJumpTable = false;
-          break;
+  // If no potential jump target addresses were found the current
+  // instruction does not compute jump table base.
+  if (JmpTgtMBBvec.size() == 0)
+    return JmpTgtMBBvec;
+
+  // Check to verify the current  block - JmpTblBaseCalcMBB - terminates
+  // with an indirect branch.
+  for (auto &T : JmpTblBaseCalcMBB.terminators()) {
+    if (!T.isIndirectBranch()) {
+      JmpTgtMBBvec.clear();
+      return JmpTgtMBBvec;
+    }
+  }
+
+  if (InstKind == InstructionKind::MOV_FROM_MEM) {
+    // Check to verify the current  block - JmpTblBaseCalcMBB - with the
+    // instruction that potentially calculates jump table base does indeed
+    // have register-based branch as the terminator and that register does
+    // not get redefined by any intervening instruction.
+    // NOTE: This check is not needed for branch with memory operand.
+    unsigned SR = find64BitSuperReg(JmpTblBaseReg);
+
+    for (MachineBasicBlock::const_instr_iterator instIter =
+             MI.getNextNode()->getIterator();
+         instIter != JmpTblBaseCalcMBB.end(); ++instIter) {
+      for (auto O : instIter->defs()) {
+        if (O.isReg() && (find64BitSuperReg(O.getReg()) == SR)) {
+          JmpTgtMBBvec.clear();
+          return JmpTgtMBBvec;
         }
       }
+    }
+  }
 
-      if (!BuildJumpTable)
-        continue;
+  return JmpTgtMBBvec;
+}
 
-      if (InstKind == InstructionKind::MOV_FROM_MEM) {
-        // Check to verify the current  block - JmpTblBaseCalcMBB - with the
-        // instruction that potentially calculates jump table base does indeed
-        // have register-based branch as the terminator and that register does
-        // not get redefined by any intervening instruction.
-        // NOTE: This check is not needed for branch with memory operand.
-        unsigned SR = find64BitSuperReg(JmpTblBaseReg);
-
-        for (MachineBasicBlock::const_instr_iterator instIter =
-                 JmpTblOffsetCalcMI.getNextNode()->getIterator();
-             instIter != JmpTblBaseCalcMBB.end(); ++instIter) {
-          for (auto O : instIter->defs()) {
-            if (O.isReg()) {
-              if (find64BitSuperReg(O.getReg()) == SR) {
-                BuildJumpTable = false;
-                break;
-              }
-            }
-          }
-          if (!BuildJumpTable)
-            break;
-        }
+bool X86MachineInstructionRaiser::raiseMachineJumpTable() {
+  // A vector to record MBBS that need be erased upon jump table creation.
+  std::vector<MachineBasicBlock *> MBBsToBeErased;
 
-        if (!BuildJumpTable)
-          continue;
-      }
+  // Get the MIs which potentially load the jumptable base address.
+  for (MachineBasicBlock &JmpTblBaseCalcMBB : MF) {
+    for (MachineBasicBlock::iterator CurMBBIter = JmpTblBaseCalcMBB.begin();
+         CurMBBIter != JmpTblBaseCalcMBB.end(); CurMBBIter++) {
+      MachineInstr &JmpTblOffsetCalcMI = (*CurMBBIter);
+      // A vector of switch target MBBs
+      std::vector<MachineBasicBlock *> JmpTgtMBBvec =
+          getJumpTableTargets(JmpTblOffsetCalcMI);
+      if (JmpTgtMBBvec.empty())
+        continue;
 
       // With all the checks done, we can safely assume that this is a block
       // that computes the base of jumptables and delete it.
@@ -326,6 +314,24 @@ bool X86MachineInstructionRaiser::raiseMachineJumpTable() {
   return true;
 }
 
+// Discover jump tables of MF without raising them. Unlike
+// raiseMachineJumpTable(), no block is erased and no branch is rewritten.
+// Blocks that branch through a jump table need not have the shape of a
+// lowered switch.
+void X86MachineInstructionRaiser::discoverJumpTables(
+    std::vector<DiscoveredJumpTable> &JumpTables) {
+  for (MachineBasicBlock &MBB : MF) {
+    for (MachineInstr &MI : MBB) {
+      std::vector<MachineBasicBlock *> TargetMBBs = getJumpTableTargets(MI);
+      if (TargetMBBs.empty())
+        continue;
+      JumpTables.push_back({&MBB, std::move(TargetMBBs)});
+      // A block branches through at most one jump table.
+      break;
+    }
+  }
+}
+
 // Return the Value * representing the value used to be searched in the given
 // MachineBasicBlock with a jmp to jump-table.
 Value *
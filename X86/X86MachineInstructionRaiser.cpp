@@ -15,8 +15,10 @@
 #include "ExternalFunctions.h"
 #include "MachineFunctionRaiser.h"
 #include "X86InstrBuilder.h"
+#include "X86InstrSemantics.h"
 #include "X86ModuleRaiser.h"
 #include "X86RaisedValueTracker.h"
+#include "X86RegisterLiveness.h"
 #include "X86RegisterUtils.h"
 #include "llvm-mctoll.h"
 #include "llvm/ADT/DepthFirstIterator.h"
@@ -61,6 +63,12 @@ X86MachineInstructionRaiser::X86MachineInstructionRaiser(MachineFunction &MF,
     FPUStack.Regs[i] = nullptr;
 
   raisedValues = nullptr;
+  regLiveness = nullptr;
+}
+
+X86MachineInstructionRaiser::~X86MachineInstructionRaiser() {
+  delete raisedValues;
+  delete regLiveness;
 }
 
 bool X86MachineInstructionRaiser::raisePushInstruction(const MachineInstr &mi) {
@@ -1854,6 +1862,272 @@ bool X86MachineInstructionRaiser::raiseMoveToMemInstr(const MachineInstr &MI,
   return true;
 }
 
+// Return the overflow bit of the result of the *_with_overflow intrinsic
+// IntrinsicKind applied to Arg0 and Arg1. Used to compute CF and OF of atomic
+// memory operations whose result is not an ordinary binary operator.
+static Value *getOverflowBit(Module *M, Intrinsic::ID IntrinsicKind,
+                             Value *Arg0, Value *Arg1, const Twine &Name,
+                             BasicBlock *RaisedBB) {
+  assert((Arg0->getType() == Arg1->getType()) &&
+         "Differing types of overflow test values not expected");
+  Function *IntrinsicFunc =
+      Intrinsic::getDeclaration(M, IntrinsicKind, Arg0->getType());
+  Value *IntrinsicCallArgs[] = {Arg0, Arg1};
+  CallInst *OverflowCall =
+      CallInst::Create(IntrinsicFunc, ArrayRef<Value *>(IntrinsicCallArgs));
+  RaisedBB->getInstList().push_back(OverflowCall);
+  return ExtractValueInst::Create(OverflowCall, 1, Name, RaisedBB);
+}
+
+// Raise atomic memory operations - viz., instructions that are implicitly
+// locked (xchg, xadd and cmpxchg with memory operand) and read-modify-write
+// instructions with lock prefix. Locked instructions are full barriers per
+// x86-TSO: loads and stores are not reordered across them. The atomic
+// operation is raised with seq_cst ordering and bracketed by seq_cst fences
+// so that surrounding memory accesses need not be made atomic.
+bool X86MachineInstructionRaiser::raiseAtomicMemOpInstr(const MachineInstr &MI,
+                                                        Value *MemRefVal) {
+  // Get the BasicBlock corresponding to MachineBasicBlock of MI.
+  // Raised instruction is added to this BasicBlock.
+  BasicBlock *RaisedBB = getRaisedBasicBlock(MI.getParent());
+  LLVMContext &Ctx(MF.getFunction().getContext());
+  int MBBNo = MI.getParent()->getNumber();
+  const AtomicOrdering Ordering = AtomicOrdering::SequentiallyConsistent;
+
+  unsigned int MemOpSize = getInstructionMemOpSize(MI.getOpcode());
+  assert((MemOpSize != 0) &&
+         "Unexpected memory operand size of atomic memory operation");
+  Type *MemTy = Type::getIntNTy(Ctx, MemOpSize * 8);
+
+  // Cast the memory reference value to pointer to MemTy, as needed.
+  Type *MemPtrTy = MemTy->getPointerTo();
+  if (MemRefVal->getType() != MemPtrTy) {
+    CastInst *CInst = CastInst::Create(
+        CastInst::getCastOpcode(MemRefVal, false, MemPtrTy, false), MemRefVal,
+        MemPtrTy);
+    RaisedBB->getInstList().push_back(CInst);
+    MemRefVal = CInst;
+  }
+
+  // EFLAGS affected by the operation and the value to test them with.
+  std::set<unsigned> AffectedEFlags;
+  std::set<unsigned> ClearedEFlags;
+  Value *EflagsTestVal = nullptr;
+  // Intrinsics computing CF and OF from the operands of the arithmetic
+  // performed by the atomic operation, if it sets them.
+  Intrinsic::ID IntrinsicCF = Intrinsic::not_intrinsic;
+  Intrinsic::ID IntrinsicOF = Intrinsic::not_intrinsic;
+  Value *FlagArgs[2] = {nullptr, nullptr};
+
+  // Determine the kind of read-modify-write operation of a locked
+  // instruction before emitting any code, so that unhandled instructions
+  // are reported without leaving a partially raised sequence.
+  AtomicRMWInst::BinOp RMWOp = AtomicRMWInst::BAD_BINOP;
+  Instruction::BinaryOps BinOp = Instruction::BinaryOpsEnd;
+  bool IsCmpXchg = instrNameStartsWith(MI, "CMPXCHG");
+  bool IsXAdd = instrNameStartsWith(MI, "XADD");
+  bool IsXchg = instrNameStartsWith(MI, "XCHG");
+  if (!IsCmpXchg && !IsXAdd && !IsXchg) {
+    if (instrNameStartsWith(MI, "INC") || instrNameStartsWith(MI, "ADD")) {
+      RMWOp = AtomicRMWInst::Add;
+      BinOp = Instruction::Add;
+    } else if (instrNameStartsWith(MI, "DEC") ||
+               instrNameStartsWith(MI, "SUB")) {
+      RMWOp = AtomicRMWInst::Sub;
+      BinOp = Instruction::Sub;
+    } else if (instrNameStartsWith(MI, "NOT") ||
+               instrNameStartsWith(MI, "XOR")) {
+      RMWOp = AtomicRMWInst::Xor;
+      BinOp = Instruction::Xor;
+    } else if (instrNameStartsWith(MI, "AND")) {
+      RMWOp = AtomicRMWInst::And;
+      BinOp = Instruction::And;
+    } else if (instrNameStartsWith(MI, "OR")) {
+      RMWOp = AtomicRMWInst::Or;
+      BinOp = Instruction::Or;
+    } else {
+      LLVM_DEBUG(dbgs() << "Unhandled instruction with lock prefix\n");
+      LLVM_DEBUG(MI.dump());
+      return false;
+    }
+  }
+
+  // Order memory accesses preceding the locked instruction.
+  RaisedBB->getInstList().push_back(new FenceInst(Ctx, Ordering));
+
+  if (IsCmpXchg) {
+    // cmpxchg compares accumulator with memory value. If equal, source
+    // register value is stored in memory. Else, memory value is loaded into
+    // accumulator. In either case the accumulator has the original memory
+    // value.
+    unsigned int AccReg = X86::NoRegister;
+    switch (MemOpSize) {
+    case 1:
+      AccReg = X86::AL;
+      break;
+    case 2:
+      AccReg = X86::AX;
+      break;
+    case 4:
+      AccReg = X86::EAX;
+      break;
+    case 8:
+      AccReg = X86::RAX;
+      break;
+    default:
+      assert(false && "Unexpected memory operand size of cmpxchg");
+    }
+    unsigned int SrcOpIndex = getMemoryRefOpIndex(MI) + X86::AddrNumOperands;
+    Value *CmpVal = getRegOrArgValue(AccReg, MBBNo);
+    Value *NewVal = getRegOperandValue(MI, SrcOpIndex);
+    assert((CmpVal != nullptr) && (NewVal != nullptr) &&
+           "Failed to get operand values of cmpxchg");
+    CmpVal = castValue(CmpVal, MemTy, RaisedBB);
+    NewVal = castValue(NewVal, MemTy, RaisedBB);
+
+    AtomicCmpXchgInst *CmpXchgInst = new AtomicCmpXchgInst(
+        MemRefVal, CmpVal, NewVal, Ordering, Ordering, SyncScope::System);
+    RaisedBB->getInstList().push_back(CmpXchgInst);
+    Value *OldVal = ExtractValueInst::Create(CmpXchgInst, 0, "", RaisedBB);
+    raisedValues->setPhysRegSSAValue(AccReg, MBBNo, OldVal);
+
+    // EFLAGS are set as per comparison of accumulator and memory value.
+    Instruction *SubInst = BinaryOperator::CreateSub(CmpVal, OldVal);
+    RaisedBB->getInstList().push_back(SubInst);
+    EflagsTestVal = SubInst;
+    AffectedEFlags.insert(EFLAGS::ZF);
+    AffectedEFlags.insert(EFLAGS::SF);
+    IntrinsicCF = Intrinsic::usub_with_overflow;
+    IntrinsicOF = Intrinsic::ssub_with_overflow;
+    FlagArgs[0] = CmpVal;
+    FlagArgs[1] = OldVal;
+  } else if (IsXAdd || IsXchg) {
+    // xadd and xchg with memory operand exchange the value of memory with
+    // the tied source register. xadd also stores the sum in memory.
+    const unsigned int DstOpIndex = 0, SrcOpIndex = 1;
+    assert((MI.findTiedOperandIdx(SrcOpIndex) == DstOpIndex) &&
+           "Expect tied operand in xadd or xchg instruction");
+    Value *SrcVal = getRegOperandValue(MI, SrcOpIndex);
+    assert((SrcVal != nullptr) &&
+           "Failed to get source value of xadd or xchg instruction");
+    SrcVal = castValue(SrcVal, MemTy, RaisedBB);
+
+    AtomicRMWInst *RMWInst = new AtomicRMWInst(
+        IsXAdd ? AtomicRMWInst::Add : AtomicRMWInst::Xchg, MemRefVal, SrcVal,
+        Ordering, SyncScope::System);
+    RaisedBB->getInstList().push_back(RMWInst);
+    raisedValues->setPhysRegSSAValue(MI.getOperand(DstOpIndex).getReg(),
+                                     MBBNo, RMWInst);
+    if (IsXAdd) {
+      Instruction *SumInst = BinaryOperator::CreateAdd(RMWInst, SrcVal);
+      RaisedBB->getInstList().push_back(SumInst);
+      EflagsTestVal = SumInst;
+      AffectedEFlags.insert(EFLAGS::ZF);
+      AffectedEFlags.insert(EFLAGS::SF);
+      IntrinsicCF = Intrinsic::uadd_with_overflow;
+      IntrinsicOF = Intrinsic::sadd_with_overflow;
+      FlagArgs[0] = RMWInst;
+      FlagArgs[1] = SrcVal;
+    }
+  } else {
+    // Read-modify-write instruction with lock prefix.
+    bool IsNot = instrNameStartsWith(MI, "NOT");
+    bool IsIncDec =
+        instrNameStartsWith(MI, "INC") || instrNameStartsWith(MI, "DEC");
+    Value *SrcVal = nullptr;
+    if (IsNot || IsIncDec) {
+      SrcVal = IsNot ? ConstantInt::getAllOnesValue(MemTy)
+                     : ConstantInt::get(MemTy, 1);
+    } else {
+      unsigned int SrcOpIndex = getMemoryRefOpIndex(MI) + X86::AddrNumOperands;
+      const MachineOperand &SrcOp = MI.getOperand(SrcOpIndex);
+      if (SrcOp.isImm())
+        SrcVal = ConstantInt::get(MemTy, SrcOp.getImm(), true /* isSigned */);
+      else
+        SrcVal = getRegOperandValue(MI, SrcOpIndex);
+      assert((SrcVal != nullptr) &&
+             "Failed to get source value of locked instruction");
+      SrcVal = castValue(SrcVal, MemTy, RaisedBB);
+    }
+
+    AtomicRMWInst *RMWInst = new AtomicRMWInst(RMWOp, MemRefVal, SrcVal,
+                                               Ordering, SyncScope::System);
+    RaisedBB->getInstList().push_back(RMWInst);
+    // not does not affect EFLAGS.
+    if (!instrNameStartsWith(MI, "NOT")) {
+      Instruction *ResultInst = BinaryOperator::Create(BinOp, RMWInst, SrcVal);
+      RaisedBB->getInstList().push_back(ResultInst);
+      EflagsTestVal = ResultInst;
+      AffectedEFlags.insert(EFLAGS::ZF);
+      AffectedEFlags.insert(EFLAGS::SF);
+      if (RMWOp == AtomicRMWInst::Add || RMWOp == AtomicRMWInst::Sub) {
+        bool IsAdd = (RMWOp == AtomicRMWInst::Add);
+        // inc and dec do not affect CF.
+        if (!IsIncDec)
+          IntrinsicCF = IsAdd ? Intrinsic::uadd_with_overflow
+                              : Intrinsic::usub_with_overflow;
+        IntrinsicOF = IsAdd ? Intrinsic::sadd_with_overflow
+                            : Intrinsic::ssub_with_overflow;
+        FlagArgs[0] = RMWInst;
+        FlagArgs[1] = SrcVal;
+      } else {
+        ClearedEFlags.insert(EFLAGS::OF);
+        ClearedEFlags.insert(EFLAGS::CF);
+      }
+    }
+  }
+
+  // Order memory accesses following the locked instruction.
+  RaisedBB->getInstList().push_back(new FenceInst(Ctx, Ordering));
+
+  for (auto Flag : ClearedEFlags)
+    raisedValues->setEflagValue(Flag, MBBNo, false);
+  for (auto Flag : AffectedEFlags)
+    raisedValues->testAndSetEflagSSAValue(Flag, MI, EflagsTestVal);
+
+  Module *M = MR->getModule();
+  if (IntrinsicCF != Intrinsic::not_intrinsic)
+    raisedValues->setPhysRegSSAValue(
+        EFLAGS::CF, MBBNo,
+        getOverflowBit(M, IntrinsicCF, FlagArgs[0], FlagArgs[1], "CF",
+                       RaisedBB));
+  if (IntrinsicOF != Intrinsic::not_intrinsic)
+    raisedValues->setPhysRegSSAValue(
+        EFLAGS::OF, MBBNo,
+        getOverflowBit(M, IntrinsicOF, FlagArgs[0], FlagArgs[1], "OF",
+                       RaisedBB));
+
+  return true;
+}
+
+// Raise fence instructions
+bool X86MachineInstructionRaiser::raiseFenceMachineInstr(
+    const MachineInstr &MI) {
+  // Get the BasicBlock corresponding to MachineBasicBlock of MI.
+  // Raised instruction is added to this BasicBlock.
+  BasicBlock *RaisedBB = getRaisedBasicBlock(MI.getParent());
+  LLVMContext &Ctx(MF.getFunction().getContext());
+
+  AtomicOrdering Ordering = AtomicOrdering::NotAtomic;
+  switch (MI.getOpcode()) {
+  case X86::MFENCE:
+    Ordering = AtomicOrdering::SequentiallyConsistent;
+    break;
+  case X86::LFENCE:
+    Ordering = AtomicOrdering::Acquire;
+    break;
+  case X86::SFENCE:
+    Ordering = AtomicOrdering::Release;
+    break;
+  default:
+    assert(false && "Unhandled fence instruction");
+    return false;
+  }
+
+  RaisedBB->getInstList().push_back(new FenceInst(Ctx, Ordering));
+  return true;
+}
+
 // load from memory, apply operation, store back to the same memory
 bool X86MachineInstructionRaiser::raiseInplaceMemOpInstr(const MachineInstr &MI,
                                                          Value *MemRefVal) {
@@ -2408,6 +2682,13 @@ bool X86MachineInstructionRaiser::raiseMemRefMachineInstr(
   assert(MemoryRefValue != nullptr &&
          "Unable to construct memory referencing value");
 
+  // Raise implicitly locked memory operations and instructions with lock
+  // prefix as atomic operations.
+  if ((getInstructionKind(Opcode) == InstructionKind::ATOMIC_MEM_OP) ||
+      isLockPrefixed(MI)) {
+    return raiseAtomicMemOpInstr(MI, MemoryRefValue);
+  }
+
   // Raise a memory compare instruction
   if (MI.isCompare()) {
     return raiseCompareMachineInstr(MI, true /* isMemRef */, MemoryRefValue);
@@ -2808,31 +3089,13 @@ bool X86MachineInstructionRaiser::raiseBinaryOpImmToRegMachineInstr(
     AdjSPRef.Base.Reg = X86::RSP;
     uint64_t Imm = MI.getOperand(SrcOp2Index).getImm();
 
-    switch (MI.getOpcode()) {
-    case X86::ADD8i8:
-    case X86::ADD16i16:
-    case X86::ADD32i32:
-    case X86::ADD64i32:
-    case X86::ADD8ri:
-    case X86::ADD16ri:
-    case X86::ADD16ri8:
-    case X86::ADD32ri:
-    case X86::ADD32ri8:
-    case X86::ADD64ri8:
-    case X86::ADD64ri32:
+    const X86InstrSemantics *Semantics = getInstrSemantics(MI.getOpcode());
+    if ((Semantics != nullptr) && (Semantics->BinOp == Instruction::Add))
       AdjSPRef.Disp = Imm;
-      break;
-    case X86::SUB32i32:
-    case X86::SUB32ri:
-    case X86::SUB32ri8:
-    case X86::SUB64ri8:
-    case X86::SUB64ri32:
-    case X86::SUB64i32:
+    else if ((Semantics != nullptr) && (Semantics->BinOp == Instruction::Sub))
       AdjSPRef.Disp = -Imm;
-      break;
-    default:
+    else
       assert(false && "SP computation - unhandled binary opcode instruction");
-    }
 
     Value *StackRefVal = getStackAllocatedValue(MI, AdjSPRef, true);
     assert((StackRefVal != nullptr) && "Reference to unallocated stack slot");
@@ -2970,225 +3233,79 @@ bool X86MachineInstructionRaiser::raiseBinaryOpImmToRegMachineInstr(
     // EFLAGS that are affected by the result of the binary operation
     std::set<unsigned> AffectedEFlags;
 
-    switch (MI.getOpcode()) {
-    case X86::ADD8i8:
-    case X86::ADD16i16:
-    case X86::ADD8ri:
-    case X86::ADD16ri:
-    case X86::ADD16ri8:
-    case X86::ADD32ri:
-    case X86::ADD32ri8:
-    case X86::ADD32i32:
-    case X86::ADD64ri8:
-    case X86::ADD64ri32:
-    case X86::ADD64i32: {
-      // Generate add instruction
-      BinOpInstr = BinaryOperator::CreateAdd(SrcOp1Value, SrcOp2Value);
-      // Clear OF and CF
-      AffectedEFlags.insert(EFLAGS::CF);
-      AffectedEFlags.insert(EFLAGS::OF);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-    } break;
-    case X86::SUB32i32:
-    case X86::SUB32ri:
-    case X86::SUB32ri8:
-    case X86::SUB64ri8:
-    case X86::SUB64ri32:
-    case X86::SUB64i32:
-      // Generate sub instruction
-      BinOpInstr = BinaryOperator::CreateSub(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      AffectedEFlags.insert(EFLAGS::CF);
-      AffectedEFlags.insert(EFLAGS::OF);
-      break;
-    case X86::AND8i8:
-    case X86::AND8ri:
-    case X86::AND16i16:
-    case X86::AND16ri:
-    case X86::AND16ri8:
-    case X86::AND32i32:
-    case X86::AND32ri:
-    case X86::AND32ri8:
-    case X86::AND64i32:
-    case X86::AND64ri8:
-    case X86::AND64ri32:
-      // Generate and instruction
-      BinOpInstr = BinaryOperator::CreateAnd(SrcOp1Value, SrcOp2Value);
-      // Clear OF and CF
-      raisedValues->setEflagValue(EFLAGS::OF, MBBNo, false);
-      raisedValues->setEflagValue(EFLAGS::CF, MBBNo, false);
-      // Test and set EFLAGs
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      // Test and set of PF not yet supported
-      break;
-    case X86::OR8i8:
-    case X86::OR8ri:
-    case X86::OR16ri8:
-    case X86::OR16i16:
-    case X86::OR16ri:
-    case X86::OR32i32:
-    case X86::OR32ri:
-    case X86::OR32ri8:
-    case X86::OR64i32:
-    case X86::OR64ri32:
-    case X86::OR64ri8:
-      // Generate or instruction
-      BinOpInstr = BinaryOperator::CreateOr(SrcOp1Value, SrcOp2Value);
-      // Clear OF and CF
-      raisedValues->setEflagValue(EFLAGS::OF, MBBNo, false);
-      raisedValues->setEflagValue(EFLAGS::CF, MBBNo, false);
-      // Test and set EFLAGs
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      // Test and set of PF not yet supported
-      break;
-    case X86::ROL8r1:
-    case X86::ROL16r1:
-    case X86::ROL32r1:
-    case X86::ROL64r1:
-      SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
-      // Mark affected EFLAGs. Note OF is affected only for 1-bit rotates.
-      AffectedEFlags.insert(EFLAGS::OF);
-      LLVM_FALLTHROUGH;
-    case X86::ROL8ri:
-    case X86::ROL16ri:
-    case X86::ROL32ri:
-    case X86::ROL64ri: {
-      // Generate the call to instrinsic
-      auto IntrinsicKind = Intrinsic::fshl;
-      Module *M = MR->getModule();
-      Function *IntrinsicFunc =
-          Intrinsic::getDeclaration(M, IntrinsicKind, SrcOp1Value->getType());
-      Value *IntrinsicCallArgs[] = {SrcOp1Value, SrcOp1Value, SrcOp2Value};
+    // Instructions whose semantics is a single binary operation are raised
+    // using the semantics table.
+    const X86InstrSemantics *Semantics = getInstrSemantics(MI.getOpcode());
+    if (Semantics != nullptr) {
+      if (Semantics->ImplicitSrc2 != 0)
+        SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(),
+                                       Semantics->ImplicitSrc2);
       BinOpInstr =
-          CallInst::Create(IntrinsicFunc, ArrayRef<Value *>(IntrinsicCallArgs));
-      // Mark affected EFLAGs
-      AffectedEFlags.insert(EFLAGS::CF);
-    } break;
-    case X86::ROR8r1:
-    case X86::ROR16r1:
-    case X86::ROR32r1:
-    case X86::ROR64r1:
-      SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
-      // Mark affected EFLAGs. Note OF is affected only for 1-bit rotates.
-      AffectedEFlags.insert(EFLAGS::OF);
-      LLVM_FALLTHROUGH;
-    case X86::ROR8ri:
-    case X86::ROR16ri:
-    case X86::ROR32ri:
-    case X86::ROR64ri: {
-      // Generate the call to instrinsic
-      auto IntrinsicKind = Intrinsic::fshr;
-      Module *M = MR->getModule();
-      Function *IntrinsicFunc =
-          Intrinsic::getDeclaration(M, IntrinsicKind, SrcOp1Value->getType());
-      Value *IntrinsicCallArgs[] = {SrcOp1Value, SrcOp1Value, SrcOp2Value};
-      BinOpInstr =
-          CallInst::Create(IntrinsicFunc, ArrayRef<Value *>(IntrinsicCallArgs));
-      // Mark affected EFLAGs
-      AffectedEFlags.insert(EFLAGS::CF);
-    } break;
-
-    case X86::XOR8ri:
-    case X86::XOR16ri:
-    case X86::XOR32ri:
-    case X86::XOR8i8:
-    case X86::XOR16i16:
-    case X86::XOR32i32:
-      // Generate xor instruction
-      BinOpInstr = BinaryOperator::CreateXor(SrcOp1Value, SrcOp2Value);
-      // Clear OF and CF
-      raisedValues->setEflagValue(EFLAGS::OF, MBBNo, false);
-      raisedValues->setEflagValue(EFLAGS::CF, MBBNo, false);
-      // Test and set EFLAGs
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      // Test and set of PF not yet supported
-      break;
-    case X86::IMUL16rri:
-    case X86::IMUL32rri:
-    case X86::IMUL32rri8:
-    case X86::IMUL64rri8:
-    case X86::IMUL64rri32:
-      BinOpInstr = BinaryOperator::CreateMul(SrcOp1Value, SrcOp2Value);
-      // OF is also affected, but is set to be the same as CF. Setting of OF for
-      // IMUL is handled along with setting of CF. So, there is no need to add
-      // OF as affected flag.
-      AffectedEFlags.insert(EFLAGS::CF);
-      break;
-    case X86::SHR8r1:
-    case X86::SHR16r1:
-    case X86::SHR32r1:
-    case X86::SHR64r1:
-      SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
-      LLVM_FALLTHROUGH;
-    case X86::SHR8ri:
-    case X86::SHR16ri:
-    case X86::SHR32ri:
-    case X86::SHR64ri:
-      // Generate shr instruction
-      BinOpInstr = BinaryOperator::CreateLShr(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    case X86::SHL8ri:
-    case X86::SHL16ri:
-    case X86::SHL32ri:
-    case X86::SHL64ri:
-      // Generate shl instruction
-      BinOpInstr = BinaryOperator::CreateShl(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    case X86::SAR8ri:
-    case X86::SAR16ri:
-    case X86::SAR32ri:
-    case X86::SAR64ri:
-      // Generate shr instruction
-      BinOpInstr = BinaryOperator::CreateLShr(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    case X86::TEST8i8:
-    case X86::TEST16i16:
-    case X86::TEST32i32:
-    case X86::TEST64i32:
-    case X86::TEST8ri:
-    case X86::TEST16ri:
-    case X86::TEST32ri:
-      BinOpInstr = BinaryOperator::CreateAnd(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    case X86::INC8r:
-    case X86::INC16r:
-    case X86::INC16r_alt:
-    case X86::INC32r:
-    case X86::INC32r_alt:
-    case X86::INC64r:
-      SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
-      BinOpInstr = BinaryOperator::CreateAdd(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    case X86::DEC8r:
-    case X86::DEC16r:
-    case X86::DEC16r_alt:
-    case X86::DEC32r:
-    case X86::DEC32r_alt:
-    case X86::DEC64r:
-      SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
-      BinOpInstr = BinaryOperator::CreateSub(SrcOp1Value, SrcOp2Value);
-      AffectedEFlags.insert(EFLAGS::SF);
-      AffectedEFlags.insert(EFLAGS::ZF);
-      break;
-    default:
-      LLVM_DEBUG(MI.dump());
-      assert(false && "Unhandled reg to imm binary operator instruction");
-      break;
+          BinaryOperator::Create(Semantics->BinOp, SrcOp1Value, SrcOp2Value);
+      const std::pair<uint8_t, unsigned> FlagEffects[] = {
+          {FLAG_CF, EFLAGS::CF},
+          {FLAG_ZF, EFLAGS::ZF},
+          {FLAG_SF, EFLAGS::SF},
+          {FLAG_OF, EFLAGS::OF}};
+      for (auto &FlagEffect : FlagEffects) {
+        if (Semantics->ClearedFlags & FlagEffect.first)
+          raisedValues->setEflagValue(FlagEffect.second, MBBNo, false);
+        if (Semantics->TestedFlags & FlagEffect.first)
+          AffectedEFlags.insert(FlagEffect.second);
+      }
+    } else {
+      switch (MI.getOpcode()) {
+      case X86::ROL8r1:
+      case X86::ROL16r1:
+      case X86::ROL32r1:
+      case X86::ROL64r1:
+        SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
+        // Mark affected EFLAGs. Note OF is affected only for 1-bit rotates.
+        AffectedEFlags.insert(EFLAGS::OF);
+        LLVM_FALLTHROUGH;
+      case X86::ROL8ri:
+      case X86::ROL16ri:
+      case X86::ROL32ri:
+      case X86::ROL64ri: {
+        // Generate the call to instrinsic
+        auto IntrinsicKind = Intrinsic::fshl;
+        Module *M = MR->getModule();
+        Function *IntrinsicFunc =
+            Intrinsic::getDeclaration(M, IntrinsicKind, SrcOp1Value->getType());
+        Value *IntrinsicCallArgs[] = {SrcOp1Value, SrcOp1Value, SrcOp2Value};
+        BinOpInstr = CallInst::Create(IntrinsicFunc,
+                                      ArrayRef<Value *>(IntrinsicCallArgs));
+        // Mark affected EFLAGs
+        AffectedEFlags.insert(EFLAGS::CF);
+      } break;
+      case X86::ROR8r1:
+      case X86::ROR16r1:
+      case X86::ROR32r1:
+      case X86::ROR64r1:
+        SrcOp2Value = ConstantInt::get(SrcOp1Value->getType(), 1);
+        // Mark affected EFLAGs. Note OF is affected only for 1-bit rotates.
+        AffectedEFlags.insert(EFLAGS::OF);
+        LLVM_FALLTHROUGH;
+      case X86::ROR8ri:
+      case X86::ROR16ri:
+      case X86::ROR32ri:
+      case X86::ROR64ri: {
+        // Generate the call to instrinsic
+        auto IntrinsicKind = Intrinsic::fshr;
+        Module *M = MR->getModule();
+        Function *IntrinsicFunc =
+            Intrinsic::getDeclaration(M, IntrinsicKind, SrcOp1Value->getType());
+        Value *IntrinsicCallArgs[] = {SrcOp1Value, SrcOp1Value, SrcOp2Value};
+        BinOpInstr = CallInst::Create(IntrinsicFunc,
+                                      ArrayRef<Value *>(IntrinsicCallArgs));
+        // Mark affected EFLAGs
+        AffectedEFlags.insert(EFLAGS::CF);
+      } break;
+      default:
+        LLVM_DEBUG(MI.dump());
+        assert(false && "Unhandled reg to imm binary operator instruction");
+        break;
+      }
     }
 
     // Insert the binary operation instruction
@@ -3580,6 +3697,9 @@ bool X86MachineInstructionRaiser::raiseGenericMachineInstr(
   case InstructionKind::FPU_REG_OP:
     success = raiseFPURegisterOpInstr(MI);
     break;
+  case InstructionKind::FENCE:
+    success = raiseFenceMachineInstr(MI);
+    break;
   case InstructionKind::DIVIDE_REG_OP: {
     const MachineOperand &SrcOp = MI.getOperand(0);
     assert(SrcOp.isReg() &&
@@ -3648,8 +3768,12 @@ bool X86MachineInstructionRaiser::raiseBranchMachineInstrs() {
       const MCInstrDesc &MCID = MI->getDesc();
       uint64_t imm = MCID.TSFlags & X86II::ImmMask;
 
-      if ((imm == X86II::Imm8PCRel) || (imm == X86II::Imm16PCRel) ||
-          (imm == X86II::Imm32PCRel)) {
+      if (decisionTreeSwitches.find(MI->getParent()->getNumber()) !=
+          decisionTreeSwitches.end()) {
+        success &= raiseDecisionTreeSwitch(CTRec);
+        assert(success && "Failed to raise decision tree switch");
+      } else if ((imm == X86II::Imm8PCRel) || (imm == X86II::Imm16PCRel) ||
+                 (imm == X86II::Imm32PCRel)) {
         success &= raiseDirectBranchMachineInstr(CTRec);
         assert(success && "Failed to raise direct branch instruction");
       } else {
@@ -3816,10 +3940,14 @@ bool X86MachineInstructionRaiser::raiseCallMachineInstr(
       // predecessors.
       bool HasCallInst = false;
       unsigned int ArgNo = 1;
-      // Find if CurMBB has call between block entry and MI
+      // Find registers defined in CurMBB between MI and the preceding call
+      // or block entry; and if CurMBB has call between block entry and MI
+      X86RegisterLiveness *RegLiveness = getRegisterLiveness();
+      MCPhysRegSet DefsBeforeCall =
+          RegLiveness->getDefsBeforeInstr(MI, HasCallInst);
 
       for (auto ArgReg : GPR64ArgRegs64Bit) {
-        if (hasPhysRegDefInBlock(ArgReg, &MI, CurMBB, MCID::Call, HasCallInst))
+        if (DefsBeforeCall.find(ArgReg) != DefsBeforeCall.end())
           PositionMask |= (1 << ArgNo);
         else if (!HasCallInst) {
           // Look to see if the argument register has a reaching definition in
@@ -3843,9 +3971,8 @@ bool X86MachineInstructionRaiser::raiseCallMachineInstr(
                 // the block. This is the reason we can not use
                 // getReachingDefs() which does not consider the position
                 // where the register is defined.
-                bool Ignored;
-                if (hasPhysRegDefInBlock(ArgReg, nullptr, PredMBB, MCID::Call,
-                                         Ignored))
+                if (RegLiveness->isDefinedAfterLastCall(ArgReg,
+                                                        PredMBB->getNumber()))
                   ReachDefPredEdgeCount++;
                 else {
                   // Reach info not found, continue walking the predecessors
@@ -4060,7 +4187,11 @@ bool X86MachineInstructionRaiser::raiseCallMachineInstr(
 bool X86MachineInstructionRaiser::raiseMachineInstr(MachineInstr &MI) {
   const MCInstrDesc &MIDesc = MI.getDesc();
 
-  if (MIDesc.mayLoad() || MIDesc.mayStore()) {
+  // Fence instructions are modeled as loading from and storing to memory,
+  // but have no memory operands.
+  if (getInstructionKind(MI.getOpcode()) == InstructionKind::FENCE) {
+    return raiseGenericMachineInstr(MI);
+  } else if (MIDesc.mayLoad() || MIDesc.mayStore()) {
     return raiseMemRefMachineInstr(MI);
   } else if (MIDesc.isReturn()) {
     return raiseReturnMachineInstr(MI);
@@ -4094,6 +4225,9 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
     raisedValues->setPhysRegSSAValue(X86::RCX, 0, Zero64BitValue);
   }
 
+  // Find compare-and-branch trees to be raised as switch instructions.
+  discoverDecisionTreeSwitches();
+
   // Walk basic blocks of the MachineFunction in LoopTraversal - except that
   // do not walk the block coming from back edge.By performing this
   // traversal, the idea is to make sure predecessors are translated before
@@ -4101,9 +4235,8 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
 
   // Raise all non control transfer MachineInstrs of each MachineBasicBlocks
   // of MachineFunction, except branch instructions.
-  LoopTraversal Traversal;
-  LoopTraversal::TraversalOrder TraversedMBBOrder = Traversal.traverse(MF);
-  for (LoopTraversal::TraversedMBBInfo TraversedMBB : TraversedMBBOrder) {
+  for (const LoopTraversal::TraversedMBBInfo &TraversedMBB :
+       getTraversalOrder()) {
     // Only perform the primary pass as we do not want to translate one
     // block more than once.
     if (!TraversedMBB.PrimaryPass)
@@ -4111,6 +4244,9 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
     MachineBasicBlock &MBB = *(TraversedMBB.MBB);
     // Get the number of MachineBasicBlock being looked at.
     int MBBNo = MBB.getNumber();
+    // Blocks subsumed by a switch raised for a decision tree are not raised.
+    if (isDecisionTreeInteriorMBB(MBBNo))
+      continue;
     // Name of the corresponding BasicBlock to be created
     std::string BBName = MBBNo == 0 ? "entry" : "bb." + std::to_string(MBBNo);
     // Create a BasicBlock instance corresponding to MBB being looked at.
@@ -4122,12 +4258,6 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
     mbbToBBMap.insert(std::make_pair(MBBNo, CurIBB));
     // Walk MachineInsts of the MachineBasicBlock
     for (MachineInstr &MI : MBB.instrs()) {
-      // Ignore padding instructions. ld uses nop and lld uses int3 for
-      // alignment padding in text section
-      auto Opcode = MI.getOpcode();
-      if (isNoop(Opcode) || (Opcode == X86::INT3)) {
-        continue;
-      }
       // If this is a terminator instruction, record
       // necessary information to raise it in a later pass.
       if (MI.isTerminator() && !MI.isReturn()) {
@@ -4136,9 +4266,11 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
       }
       if (MI.isCall()) {
         if (!raiseCallMachineInstr(MI)) {
+          FailedOpcode = MI.getOpcode();
           return false;
         }
       } else if (!raiseMachineInstr(MI)) {
+        FailedOpcode = MI.getOpcode();
         return false;
       }
     }
@@ -17,6 +17,7 @@
 #include "MachineInstructionRaiser.h"
 #include "X86AdditionalInstrInfo.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/ValueHandle.h"
 
 /*
  * Type alias for Map of MBBNo -> BasicBlock * used to keep track of
@@ -40,6 +41,8 @@ using MCPhysRegSizeMap = std::map<MCPhysReg, uint16_t>;
 
 // Forward declaration of X86RaisedValueTracker
 class X86RaisedValueTracker;
+// Forward declaration of X86RegisterLiveness
+class X86RegisterLiveness;
 
 namespace llvm {
 class X86Subtarget;
@@ -53,6 +56,7 @@ public:
   X86MachineInstructionRaiser() = delete;
   X86MachineInstructionRaiser(MachineFunction &MF, const ModuleRaiser *MR,
                               MCInstRaiser *MIR);
+  ~X86MachineInstructionRaiser();
   bool raise();
 
   // Return the 64-bit super-register of PhysReg.
@@ -67,7 +71,13 @@ public:
                                        int MBBNo, AllocaInst *Alloca);
   int getArgumentNumber(unsigned PReg);
   bool instrNameStartsWith(const MachineInstr &MI, StringRef name) const;
+  bool isLockPrefixed(const MachineInstr &MI);
   X86RaisedValueTracker *getRaisedValues() { return raisedValues; }
+  X86RegisterLiveness *getRegisterLiveness();
+  bool isDirectTailCall(const MachineInstr &MI);
+  bool releaseRaiserState();
+  unsigned getNumFlagValues() const;
+  void discoverJumpTables(std::vector<DiscoveredJumpTable> &JumpTables);
 
 private:
   // Bit positions used for individual status flags of EFLAGS register.
@@ -84,6 +94,10 @@ private:
 
   X86RaisedValueTracker *raisedValues;
 
+  // Register liveness of blocks of the function. Computed once CFG of the
+  // function is final.
+  X86RegisterLiveness *regLiveness;
+
   // Set of reaching definitions that were not promoted during since defining
   // block is not yet raised and need to be promoted upon raising all blocks.
   std::set<PhysRegMBBValTuple> reachingDefsToPromote;
@@ -101,6 +115,21 @@ private:
   // A map of MachineFunctionBlock number to BasicBlock *
   MBBNumToBBMap mbbToBBMap;
 
+  // Per-block caches of values generated while raising, used to avoid
+  // generating duplicate casts and address computations in a block. These
+  // are keyed by SSA values of the operands. So redefinition of a register
+  // results in a new key.
+  // Map of <BasicBlock, SrcValue, DstTy> -> cast of SrcValue to DstTy
+  std::map<std::tuple<BasicBlock *, Value *, Type *>, WeakTrackingVH>
+      castValueCache;
+  // Map of <BasicBlock, BaseValue, IndexValue, Scale> -> Base + Index * Scale
+  std::map<std::tuple<BasicBlock *, Value *, Value *, unsigned>,
+           WeakTrackingVH>
+      scaledIndexBaseCache;
+  // Map of <BasicBlock, Value, Disp> -> Value + Disp
+  std::map<std::tuple<BasicBlock *, Value *, int64_t>, WeakTrackingVH>
+      dispAddCache;
+
   // Commonly used LLVM data structures during this phase
   MachineRegisterInfo &machineRegInfo;
   const X86Subtarget &x86TargetInfo;
@@ -140,6 +169,8 @@ private:
   bool raiseLoadIntToFloatRegInstr(const MachineInstr &, Value *);
   bool raiseStoreIntToFloatRegInstr(const MachineInstr &, Value *);
   bool raiseFPURegisterOpInstr(const MachineInstr &);
+  bool raiseAtomicMemOpInstr(const MachineInstr &, Value *);
+  bool raiseFenceMachineInstr(const MachineInstr &);
 
   bool raiseBranchMachineInstrs();
   bool raiseDirectBranchMachineInstr(ControlTransferInfo *);
@@ -147,8 +178,6 @@ private:
 
   // Helper functions
   // Cleanup MachineBasicBlocks
-  bool deleteNOOPInstrMI(MachineBasicBlock &, MachineBasicBlock::iterator);
-  bool deleteNOOPInstrMF();
   bool unlinkEmptyMBBs();
   // Adjust sizes of stack allocated objects
   bool adjustStackAllocatedObjects();
@@ -159,6 +188,13 @@ private:
 
   // Raise Machine Jumptable
   bool raiseMachineJumpTable();
+  // Get the targets of the jump table whose base is computed by MI
+  std::vector<MachineBasicBlock *> getJumpTableTargets(MachineInstr &MI);
+
+  // Discover and raise compare-and-branch decision trees as switches
+  bool discoverDecisionTreeSwitches();
+  bool isDecisionTreeInteriorMBB(int MBBNo) const;
+  bool raiseDecisionTreeSwitch(ControlTransferInfo *);
 
   Value *getSwitchCompareValue(MachineBasicBlock &mbb);
 
@@ -173,6 +209,7 @@ private:
   Value *getGlobalVariableValueAt(const MachineInstr &, uint64_t);
   const Value *getOrCreateGlobalRODataValueAtOffset(int64_t Offset,
                                                     Type *OffsetTy);
+  GlobalVariable *getOrCreateDataSectionGlobal(const SectionRef &Sec);
   Value *getMemoryAddressExprValue(const MachineInstr &);
   Value *createPCRelativeAccesssValue(const MachineInstr &);
 
@@ -191,10 +228,6 @@ private:
 
   bool handleUnpromotedReachingDefs();
 
-  bool hasPhysRegDefInBlock(int PhysReg, const MachineInstr *StartMI,
-                            const MachineBasicBlock *MBB,
-                            unsigned StopAtInstProp, bool &HasStopInst);
-
   void addRegisterToFunctionLiveInSet(MCPhysRegSet &CurLiveSet, unsigned Reg);
   int64_t getBranchTargetMBBNumber(const MachineInstr &MI);
   Function *getCalledFunction(const MachineInstr &MI);
@@ -202,6 +235,8 @@ private:
   // Cast SrcVal to type DstTy, if the type of SrcVal is different from DstTy.
   // Return the cast instruction upon inserting it at the end of InsertBlock
   Value *castValue(Value *SrcVal, Type *DstTy, BasicBlock *InsertBlock);
+  Value *getCachedBlockValue(const WeakTrackingVH &CachedVal,
+                             BasicBlock *Block);
   Type *getImmOperandType(const MachineInstr &MI, unsigned int OpIndex);
   uint8_t getPhysRegOperandSize(const MachineInstr &MI, unsigned int OpIndex);
   Type *getPhysRegOperandType(const MachineInstr &MI, unsigned int OpIndex);
@@ -225,6 +260,25 @@ private:
   };
 
   std::vector<JumpTableInfo> jtList;
+
+  // A tree of compare-and-branch blocks that tests a single register against
+  // constants, rooted at a block with a conditional branch.
+  struct DecisionTreeSwitchInfo {
+    // Compare instruction of the root block
+    const MachineInstr *CompareMI;
+
+    // Default Machine BasicBlock.
+    MachineBasicBlock *DefaultMBB;
+
+    // Case values and the corresponding target Machine BasicBlocks.
+    std::vector<std::pair<APInt, MachineBasicBlock *>> Cases;
+  };
+
+  // Map of MBBNo of tree root -> DecisionTreeSwitchInfo
+  std::map<int, DecisionTreeSwitchInfo> decisionTreeSwitches;
+  // Set of MBBNos of non-root blocks of decision trees. These are subsumed by
+  // the switch raised in the root block and are not raised.
+  std::set<int> decisionTreeInteriorMBBNos;
   // Set of MBBNos that end with tail calls
   std::set<int> tailCallMBBNos;
 };
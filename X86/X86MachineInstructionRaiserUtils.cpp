@@ -14,6 +14,7 @@
 #include "ExternalFunctions.h"
 #include "X86MachineInstructionRaiser.h"
 #include "X86RaisedValueTracker.h"
+#include "X86RegisterLiveness.h"
 #include "X86RegisterUtils.h"
 #include "llvm-mctoll.h"
 #include "llvm/Object/ELF.h"
@@ -25,46 +26,44 @@ using namespace llvm;
 using namespace mctoll;
 using namespace X86RegisterUtils;
 
+// Return the value cached in CachedVal, if it can be used by an instruction
+// added at the end of Block. A cached instruction is usable only if it is
+// still in Block, which is the case unless it was deleted or moved.
+Value *X86MachineInstructionRaiser::getCachedBlockValue(
+    const WeakTrackingVH &CachedVal, BasicBlock *Block) {
+  Value *Val = CachedVal;
+  if (Val == nullptr)
+    return nullptr;
+  if (auto *CachedInst = dyn_cast<Instruction>(Val))
+    if (CachedInst->getParent() != Block)
+      return nullptr;
+  return Val;
+}
+
 // Cast SrcVal to the type of DstVal, if their types are different.
-// Return the cast instruction upon inserting it at the end of InsertBlock
+// Return the cast instruction upon inserting it at the end of InsertBlock.
+// A cast of SrcVal to DstTy already generated in InsertBlock is reused.
 Value *X86MachineInstructionRaiser::castValue(Value *SrcValue, Type *DstTy,
                                               BasicBlock *InsertBlock) {
   if (SrcValue->getType() != DstTy) {
+    auto CacheKey = std::make_tuple(InsertBlock, SrcValue, DstTy);
+    auto CacheIter = castValueCache.find(CacheKey);
+    if (CacheIter != castValueCache.end()) {
+      if (Value *CachedVal =
+              getCachedBlockValue(CacheIter->second, InsertBlock))
+        return CachedVal;
+    }
     Instruction *CInst =
         CastInst::Create(CastInst::getCastOpcode(SrcValue, false, DstTy, false),
                          SrcValue, DstTy);
     // Add the cast instruction RaisedBB.
     InsertBlock->getInstList().push_back(CInst);
+    castValueCache[CacheKey] = CInst;
     return CInst;
   } else
     return SrcValue;
 }
 
-// Delete noop instructions
-bool X86MachineInstructionRaiser::deleteNOOPInstrMI(
-    MachineBasicBlock &MBB, MachineBasicBlock::iterator MBBI) {
-  MachineInstr &MI = *MBBI;
-  if (isNoop(MI.getOpcode())) {
-    MBB.remove(&MI);
-    return true;
-  }
-  return false;
-}
-
-bool X86MachineInstructionRaiser::deleteNOOPInstrMF() {
-  bool modified = false;
-  for (MachineBasicBlock &MBB : MF) {
-    // MBBI may be invalidated by the raising operation.
-    MachineBasicBlock::iterator MBBI = MBB.begin(), E = MBB.end();
-    while (MBBI != E) {
-      MachineBasicBlock::iterator NMBBI = std::next(MBBI);
-      modified |= deleteNOOPInstrMI(MBB, MBBI);
-      MBBI = NMBBI;
-    }
-  }
-  return modified;
-}
-
 bool X86MachineInstructionRaiser::unlinkEmptyMBBs() {
   bool modified = false;
   std::set<unsigned> EmptyMBBNos;
@@ -197,46 +196,63 @@ bool X86MachineInstructionRaiser::recordDefsToPromote(unsigned PhysReg,
   return true;
 }
 
-// Return true if MBB has a definition of PhysReg in the instruction range
-// [StopInst, StartMI) where StopInst is the last instance of instruction with
-// the opcode property StopAtInstProp. For example, if StopAtInstProp is
-// MCID::Call, this function returns true if PhysReg is defined in the range
-// [LCI, StartInst) where LCI is the last call instruction in MBB.
-//
-// If StartMI is nullptr, the range searched in [StopInst, BlockEndInst].
-bool X86MachineInstructionRaiser::hasPhysRegDefInBlock(
-    int PhysReg, const MachineInstr *StartMI, const MachineBasicBlock *MBB,
-    unsigned StopAtInstProp, bool &HasStopInst) {
-  // Walk backwards starting from the instruction before StartMI
-  MachineBasicBlock::const_reverse_iterator InstIter;
-  HasStopInst = false; // default value
-  InstIter = (StartMI == nullptr) ? MBB->rend() : StartMI->getReverseIterator();
-
-  unsigned SuperReg = find64BitSuperReg(PhysReg);
-
-  for (const MachineInstr &MI : make_range(++InstIter, MBB->rend())) {
-    // Stop after the instruction with the specified property in the block
-    if (MI.hasProperty(StopAtInstProp)) {
-      HasStopInst = true;
-      break;
-    }
+// Return register liveness information of the function. It is computed upon
+// first request; so this should not be called before the CFG of the function
+// is final.
+X86RegisterLiveness *X86MachineInstructionRaiser::getRegisterLiveness() {
+  if (regLiveness == nullptr)
+    regLiveness = new X86RegisterLiveness(this);
+  return regLiveness;
+}
 
-    // If the instruction has a define
-    if (MI.getNumDefs() > 0) {
-      for (auto MO : MI.defs()) {
-        // If the define operand is a register
-        if (MO.isReg()) {
-          unsigned MOReg = MO.getReg();
-          if (Register::isPhysicalRegister(MOReg)) {
-            if (SuperReg == find64BitSuperReg(MOReg))
-              return true;
-          }
-        }
-      }
-    }
-  }
+// Return true if MI is a direct unconditional branch to a target outside the
+// function that is the last instruction of its block, i.e., a tail call.
+bool X86MachineInstructionRaiser::isDirectTailCall(const MachineInstr &MI) {
+  if (!MI.isUnconditionalBranch() || (MI.getNumOperands() == 0) ||
+      !MI.getOperand(0).isImm() || !X86II::isImmPCRel(MI.getDesc().TSFlags))
+    return false;
+
+  MCInstRaiser *MCIR = getMCInstRaiser();
+  assert(MCIR != nullptr && "MCInstRaiser not initialized");
+  // Get the (MCInst) offset of the instruction in the binary
+  uint64_t MCInstOffset = MCIR->getMCInstIndex(MI);
+  int64_t BranchTargetOffset = MCInstOffset +
+                               MCIR->getMCInstSize(MCInstOffset) +
+                               MI.getOperand(0).getImm();
+  // This may be a tail call if there is no MBB corresponding to the branch
+  // target offset. It is a tail call only if there are no other instructions
+  // after this unconditional branch instruction.
+  return (MCIR->getMBBNumberOfMCInstOffset(BranchTargetOffset) == -1) &&
+         (MI.getNextNode() == nullptr);
+}
 
-  return false;
+// Release the state used to raise the function. Only the raised function is
+// needed by passes that follow raising of X86 functions. Objects allocated
+// using the allocator of the function are released along with it.
+bool X86MachineInstructionRaiser::releaseRaiserState() {
+  delete raisedValues;
+  raisedValues = nullptr;
+  delete regLiveness;
+  regLiveness = nullptr;
+
+  CTInfo.clear();
+
+  reachingDefsToPromote.clear();
+  PerMBBDefinedPhysRegMap.clear();
+  mbbToBBMap.clear();
+  castValueCache.clear();
+  scaledIndexBaseCache.clear();
+  dispAddCache.clear();
+  jtList.clear();
+  decisionTreeSwitches.clear();
+  decisionTreeInteriorMBBNos.clear();
+  tailCallMBBNos.clear();
+  invalidateTraversalOrder();
+  return true;
+}
+
+unsigned X86MachineInstructionRaiser::getNumFlagValues() const {
+  return (raisedValues == nullptr) ? 0 : raisedValues->getNumEflagSSAValues();
 }
 
 // FPU Access functions
@@ -303,38 +319,13 @@ Value *X86MachineInstructionRaiser::FPURegisterStackTop() {
 
 unsigned int
 X86MachineInstructionRaiser::find64BitSuperReg(unsigned int PhysReg) {
-  unsigned int SuperReg;
-  bool SuperRegFound = false;
-
   // No super register for 0 register
-  if (PhysReg == X86::NoRegister) {
+  if (PhysReg == X86::NoRegister)
     return X86::NoRegister;
-  }
 
-  // Nothing to do if PhysReg is one of EFLAG bits, FPSW, FPCW
-  if (isEflagBit(PhysReg))
-    return PhysReg;
-
-  if ((PhysReg == X86::FPSW) || (PhysReg == X86::FPCW)) {
-    return PhysReg;
-  }
-
-  if (is64BitPhysReg(PhysReg)) {
-    SuperReg = PhysReg;
-    SuperRegFound = true;
-  } else {
-    for (MCSuperRegIterator SuperRegs(PhysReg, x86RegisterInfo);
-         SuperRegs.isValid(); ++SuperRegs) {
-      SuperReg = *SuperRegs;
-      if (is64BitPhysReg(SuperReg)) {
-        assert(SuperRegFound != true &&
-               "Expect only one 64-bit super register");
-        SuperRegFound = true;
-      }
-    }
-  }
-
-  assert(SuperRegFound && "Super register not found");
+  // EFLAG bits, FPSW and FPCW are their own super registers
+  unsigned int SuperReg = getPhysRegInfo(PhysReg).SuperReg64;
+  assert((SuperReg != X86::NoRegister) && "Super register not found");
   return SuperReg;
 }
 
@@ -508,6 +499,12 @@ Value *X86MachineInstructionRaiser::createPCRelativeAccesssValue(
             }
           }
           Constant *GlobalInit = ConstantInt::get(GlobalValTy, SymbVal);
+          // A variable defined in a shared library raised along with the
+          // binary is declared so that it resolves to its raised definition.
+          if (MR->getLibraryDefinition(Symname.get()) != nullptr) {
+            Lnkg = GlobalValue::ExternalLinkage;
+            GlobalInit = nullptr;
+          }
           auto GlobalVal = new GlobalVariable(*(MR->getModule()), GlobalValTy,
                                               false /* isConstant */, Lnkg,
                                               GlobalInit, Symname->data());
@@ -1024,6 +1021,43 @@ Function *X86MachineInstructionRaiser::getTargetFunctionAtPLTOffset(
   return CalledFunc;
 }
 
+// Return true if ELF section Sec is writable.
+static bool isWritableSection(ELFSectionRef Sec) {
+  return (Sec.getFlags() & ELF::SHF_WRITE) != 0;
+}
+
+// Return the global variable that models the contents of data section Sec.
+// The global is a byte array initialized with the exact contents of the
+// section. It is constant if the section is not writable. The global of a
+// writable section is named RW-Section<name> and that of a read-only
+// section RO-Section<name>.
+GlobalVariable *X86MachineInstructionRaiser::getOrCreateDataSectionGlobal(
+    const SectionRef &Sec) {
+  StringRef SecName =
+      unwrapOrError(Sec.getName(), MR->getObjectFile()->getFileName());
+  bool IsWritable = isWritableSection(Sec);
+  std::string RegionName =
+      ((IsWritable ? "RW-Section" : "RO-Section") + SecName).str();
+  Module *M = MR->getModule();
+  GlobalVariable *RegionGV = M->getNamedGlobal(RegionName);
+  if (RegionGV != nullptr)
+    return RegionGV;
+
+  StringRef SecData =
+      unwrapOrError(Sec.getContents(), MR->getObjectFile()->getFileName());
+  Constant *RegionInit = ConstantDataArray::get(
+      M->getContext(),
+      ArrayRef<uint8_t>(SecData.bytes_begin(), SecData.bytes_end()));
+  RegionGV = new GlobalVariable(*M, RegionInit->getType(), !IsWritable,
+                                GlobalValue::PrivateLinkage, RegionInit,
+                                RegionName);
+  uint64_t SecAlignment = Sec.getAlignment();
+  RegionGV->setAlignment(MaybeAlign(SecAlignment == 0 ? 1 : SecAlignment));
+  if (!IsWritable)
+    RegionGV->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+  return RegionGV;
+}
+
 // Return a global value corresponding to read-only  data.
 const Value *X86MachineInstructionRaiser::getOrCreateGlobalRODataValueAtOffset(
     int64_t Offset, Type *OffsetTy1) {
@@ -1047,20 +1081,28 @@ const Value *X86MachineInstructionRaiser::getOrCreateGlobalRODataValueAtOffset(
       // We know that SrcImm is a positive value. So, casting it is OK.
       if ((SecStart <= (uint64_t)Offset) && (SecEnd >= (uint64_t)Offset)) {
         if (SecIter->isData()) {
-          StringRef SecData = unwrapOrError(SecIter->getContents(),
-                                            MR->getObjectFile()->getFileName());
+          // Data of a writable section that is in the range of a data
+          // object symbol is modeled by the global variable of the symbol
+          // (see getGlobalVariableValueAt()). It is not given a second,
+          // separate storage in the section global, since stores to one
+          // would not be seen through the other.
+          if (isWritableSection(*SecIter) && MR->isDataSymbolAddress(Offset))
+            break;
+          // The data section is modeled as a single global byte array with
+          // the exact contents of the section as its initializer. Accesses
+          // to addresses in the section are raised as byte offsets into
+          // it. This allows loads from constant tables to be folded and
+          // avoids duplicating data referenced at different offsets.
+          GlobalVariable *RegionGV = getOrCreateDataSectionGlobal(*SecIter);
           unsigned DataOffset = Offset - SecStart;
-          const unsigned char *RODataBegin = SecData.bytes_begin() + DataOffset;
-          StringRef ROStringRef(reinterpret_cast<const char *>(RODataBegin));
-          Constant *StrConstant =
-              ConstantDataArray::getString(llvmContext, ROStringRef);
-          auto GlobalStrConstVal = new GlobalVariable(
-              *(MR->getModule()), StrConstant->getType(), true /* isConstant */,
-              GlobalValue::PrivateLinkage, StrConstant, "RO-String");
-          GlobalStrConstVal->setAlignment(MaybeAlign(1));
+          Constant *Idx[2] = {
+              ConstantInt::get(Type::getInt64Ty(llvmContext), 0),
+              ConstantInt::get(Type::getInt64Ty(llvmContext), DataOffset)};
+          Constant *RegionGEP = ConstantExpr::getInBoundsGetElementPtr(
+              RegionGV->getValueType(), RegionGV, Idx);
           // Record the mapping between offset and global value
-          MR->addRODataValueAt(GlobalStrConstVal, Offset);
-          RODataValue = GlobalStrConstVal;
+          MR->addRODataValueAt(RegionGEP, Offset);
+          RODataValue = RegionGEP;
         } else if (SecIter->isBSS()) {
           // Get symbol name associated with the address
           // Find symbol at Offset
@@ -1316,18 +1358,23 @@ X86MachineInstructionRaiser::getGlobalVariableValueAt(const MachineInstr &MI,
                       Ctx, APInt(MemAccessSizeInBytes * 8, SymArrayElem));
                   ConstantVec.push_back(ConstVal);
                 } else {
-                  // If SymArrElem corresponds to an .rodata address,
-                  // prepare the indices to this value to be used in the array
+                  // If SymArrElem corresponds to an .rodata address, the
+                  // value is the address of the data in the array
                   // representing the symbol value.
                   Value *GVValue = const_cast<Value *>(RoDataValue);
                   GlobalVariable *GV = dyn_cast<GlobalVariable>(GVValue);
-                  Constant *Idx[2] = {
-                      ConstantInt::get(Ctx, APInt(MemAccessSizeInBytes * 8, 0)),
-                      ConstantInt::get(Ctx, APInt(MemAccessSizeInBytes * 8, 0)),
-                  };
-                  Constant *GEP = ConstantExpr::getInBoundsGetElementPtr(
-                      GV->getValueType(), GV, Idx);
-                  ConstantVec.push_back(GEP);
+                  if (GV != nullptr) {
+                    Constant *Idx[2] = {
+                        ConstantInt::get(Ctx,
+                                         APInt(MemAccessSizeInBytes * 8, 0)),
+                        ConstantInt::get(Ctx,
+                                         APInt(MemAccessSizeInBytes * 8, 0)),
+                    };
+                    Constant *GEP = ConstantExpr::getInBoundsGetElementPtr(
+                        GV->getValueType(), GV, Idx);
+                    ConstantVec.push_back(GEP);
+                  } else
+                    ConstantVec.push_back(cast<Constant>(GVValue));
                 }
                 // Clear symbol element value
                 SymArrayElem = 0;
@@ -1397,6 +1444,16 @@ X86MachineInstructionRaiser::getGlobalVariableValueAt(const MachineInstr &MI,
           GlobalInit = ConstantInt::get(GlobalValTy, SV);
       }
 
+      // A variable of the binary in BSS that is defined in a shared library
+      // raised along with the binary is the copy of the variable made by a
+      // copy relocation. Declare it so that it resolves to the raised
+      // definition in the library, which holds its initial value.
+      if (isBSSSymbol &&
+          (MR->getLibraryDefinition(GlobalDataSymNameIndexStrRef) != nullptr)) {
+        Lnkg = GlobalValue::ExternalLinkage;
+        GlobalInit = nullptr;
+      }
+
       // Now, create the global variable for the symbol at given Offset.
       auto GlobalVal = new GlobalVariable(
           *(MR->getModule()), GlobalValTy, false /* isConstant */, Lnkg,
@@ -1507,45 +1564,68 @@ X86MachineInstructionRaiser::getMemoryAddressExprValue(const MachineInstr &MI) {
          "Unhandled memory reference instruction with non-zero segment "
          "register");
 
-  // IndexReg * ScaleAmt
-  // Generate mul scaleAmt, IndexRegVal, if IndexReg is not 0.
-  if (IndexReg != X86::NoRegister) {
-    Value *IndexRegVal =
-        getRegOrArgValue(IndexReg, MI.getParent()->getNumber());
-    switch (ScaleAmt) {
-    case 0:
-      break;
-    case 1:
-      MemrefValue = IndexRegVal;
-      break;
-    default: {
-      Type *MulValTy = IndexRegVal->getType();
-      Value *ScaleAmtValue = ConstantInt::get(MulValTy, ScaleAmt);
-      Instruction *MulInst =
-          BinaryOperator::CreateMul(ScaleAmtValue, IndexRegVal);
-      RaisedBB->getInstList().push_back(MulInst);
-      MemrefValue = MulInst;
-    } break;
-    }
+  // Address computations already generated in RaisedBB with the same base
+  // and index register values are reused. Since the computations are keyed
+  // by SSA values of the registers, a redefinition of a register invalidates
+  // them.
+  Value *IndexRegVal =
+      (IndexReg == X86::NoRegister)
+          ? nullptr
+          : getRegOrArgValue(IndexReg, MI.getParent()->getNumber());
+  Value *BaseRegVal =
+      (BaseReg == X86::NoRegister)
+          ? nullptr
+          : getRegOrArgValue(BaseReg, MI.getParent()->getNumber());
+  auto ScaledIndexBaseKey =
+      std::make_tuple(RaisedBB, BaseRegVal, IndexRegVal, ScaleAmt);
+  if (IndexRegVal != nullptr) {
+    auto CacheIter = scaledIndexBaseCache.find(ScaledIndexBaseKey);
+    if (CacheIter != scaledIndexBaseCache.end())
+      MemrefValue = getCachedBlockValue(CacheIter->second, RaisedBB);
   }
 
-  // BaseReg + IndexReg*ScaleAmt
-  // Generate add BaseRegVal, memrefVal (if IndexReg*ScaleAmt was computed)
+  if (MemrefValue == nullptr) {
+    // IndexReg * ScaleAmt
+    // Generate mul scaleAmt, IndexRegVal, if IndexReg is not 0.
+    if (IndexReg != X86::NoRegister) {
+      switch (ScaleAmt) {
+      case 0:
+        break;
+      case 1:
+        MemrefValue = IndexRegVal;
+        break;
+      default: {
+        Type *MulValTy = IndexRegVal->getType();
+        Value *ScaleAmtValue = ConstantInt::get(MulValTy, ScaleAmt);
+        Instruction *MulInst =
+            BinaryOperator::CreateMul(ScaleAmtValue, IndexRegVal);
+        RaisedBB->getInstList().push_back(MulInst);
+        MemrefValue = MulInst;
+      } break;
+      }
+    }
 
-  if (BaseReg != X86::NoRegister) {
-    Value *BaseRegVal = getRegOrArgValue(BaseReg, MI.getParent()->getNumber());
-    if (MemrefValue != nullptr) {
-      assert((BaseRegVal != nullptr) &&
-             "Unexpected null value of base reg while constructing memory "
-             "address expression");
-      // Ensure the type of BaseRegVal matched that of MemrefValue.
-      BaseRegVal = castValue(BaseRegVal, MemrefValue->getType(), RaisedBB);
-      Instruction *AddInst = BinaryOperator::CreateAdd(BaseRegVal, MemrefValue);
-      RaisedBB->getInstList().push_back(AddInst);
-      MemrefValue = AddInst;
-    } else {
-      MemrefValue = BaseRegVal;
+    // BaseReg + IndexReg*ScaleAmt
+    // Generate add BaseRegVal, memrefVal (if IndexReg*ScaleAmt was computed)
+
+    if (BaseReg != X86::NoRegister) {
+      if (MemrefValue != nullptr) {
+        assert((BaseRegVal != nullptr) &&
+               "Unexpected null value of base reg while constructing memory "
+               "address expression");
+        // Ensure the type of BaseRegVal matched that of MemrefValue.
+        BaseRegVal = castValue(BaseRegVal, MemrefValue->getType(), RaisedBB);
+        Instruction *AddInst =
+            BinaryOperator::CreateAdd(BaseRegVal, MemrefValue);
+        RaisedBB->getInstList().push_back(AddInst);
+        MemrefValue = AddInst;
+      } else {
+        MemrefValue = BaseRegVal;
+      }
     }
+
+    if ((IndexRegVal != nullptr) && (MemrefValue != nullptr))
+      scaledIndexBaseCache[ScaledIndexBaseKey] = MemrefValue;
   }
 
   // BaseReg + Index*ScaleAmt + Disp
@@ -1650,10 +1730,24 @@ X86MachineInstructionRaiser::getMemoryAddressExprValue(const MachineInstr &MI) {
               "Unhandled situation where global symbol not accessed via GEP");
         }
       }
-      // Generate add memrefVal, Disp.
-      Instruction *AddInst = BinaryOperator::CreateAdd(MemrefValue, DispValue);
-      RaisedBB->getInstList().push_back(AddInst);
-      MemrefValue = AddInst;
+      // Generate add memrefVal, Disp. Reuse the sum generated in RaisedBB, if
+      // Disp is a plain integer value.
+      auto DispAddKey = std::make_tuple(RaisedBB, MemrefValue, (int64_t)Disp);
+      Value *DispAddVal = nullptr;
+      if (GV == nullptr) {
+        auto DispAddIter = dispAddCache.find(DispAddKey);
+        if (DispAddIter != dispAddCache.end())
+          DispAddVal = getCachedBlockValue(DispAddIter->second, RaisedBB);
+      }
+      if (DispAddVal == nullptr) {
+        Instruction *AddInst =
+            BinaryOperator::CreateAdd(MemrefValue, DispValue);
+        RaisedBB->getInstList().push_back(AddInst);
+        DispAddVal = AddInst;
+        if (GV == nullptr)
+          dispAddCache[DispAddKey] = AddInst;
+      }
+      MemrefValue = DispAddVal;
       //}
     } else {
       // Check that this is an instruction of the kind
@@ -1856,12 +1950,14 @@ bool X86MachineInstructionRaiser::recordMachineInstrInfo(
   // processing at a later stage.
   if (!TailCall) {
     // Set common info of the record
-    ControlTransferInfo *CurCTInfo = new ControlTransferInfo;
+    BumpPtrAllocator &Allocator = getMCInstRaiser()->getAllocator();
+    ControlTransferInfo *CurCTInfo = new (Allocator) ControlTransferInfo;
     CurCTInfo->CandidateMachineInstr = &MI;
     CurCTInfo->CandidateBlock = RaisedBB;
 
     const MCInstrDesc &MCID = MI.getDesc();
     // Save all values of implicitly used operands
+    SmallVector<Value *, 8> RegValues;
     unsigned ImplUsesCount = MCID.getNumImplicitUses();
     if (ImplUsesCount > 0) {
       const MCPhysReg *ImplUses = MCID.getImplicitUses();
@@ -1872,17 +1968,18 @@ bool X86MachineInstructionRaiser::recordMachineInstrInfo(
             Value *Val = getRegOrArgValue(FlgBit, MI.getParent()->getNumber());
             assert((Val != nullptr) &&
                    "Unexpected null value of implicit eflags bits");
-            CurCTInfo->RegValues.push_back(Val);
+            RegValues.push_back(Val);
           }
         } else {
           Value *Val =
               getRegOrArgValue(ImplUses[i], MI.getParent()->getNumber());
           assert((Val != nullptr) &&
                  "Unexpected null value of implicit defined registers");
-          CurCTInfo->RegValues.push_back(Val);
+          RegValues.push_back(Val);
         }
       }
     }
+    CurCTInfo->RegValues = makeArrayRef(RegValues).copy(Allocator);
     CurCTInfo->Raised = false;
     CTInfo.push_back(CurCTInfo);
   }
@@ -1894,6 +1991,26 @@ bool X86MachineInstructionRaiser::instrNameStartsWith(const MachineInstr &MI,
   return x86InstrInfo->getName(MI.getOpcode()).startswith(name);
 }
 
+// Return true if MI has a lock prefix. The disassembler records the lock
+// prefix as a flag of the decoded MCInst; older decoders emit it as a
+// separate LOCK_PREFIX instruction preceding MI.
+bool X86MachineInstructionRaiser::isLockPrefixed(const MachineInstr &MI) {
+  MCInstRaiser *MCIR = getMCInstRaiser();
+  MCInstRaiser::const_mcinst_iter MCIter =
+      MCIR->getMCInstAt(MCIR->getMCInstIndex(MI));
+  assert(MCIter != MCIR->const_mcinstr_end() &&
+         "Failed to find MCInst of MachineInstr");
+  if (!(*MCIter).second.isMCInst())
+    return false;
+  if ((*MCIter).second.getMCInst().getFlags() & X86::IP_HAS_LOCK)
+    return true;
+  if (MCIter == MCIR->const_mcinstr_begin())
+    return false;
+  MCIter--;
+  return (*MCIter).second.isMCInst() &&
+         ((*MCIter).second.getMCInst().getOpcode() == X86::LOCK_PREFIX);
+}
+
 // Return a new function which is the same in every respect except with
 // specified return type.
 void X86MachineInstructionRaiser::changeRaisedFunctionReturnType(Type *RetTy) {
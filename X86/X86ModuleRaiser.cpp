@@ -12,7 +12,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "X86ModuleRaiser.h"
+#include "MachineFunctionRaiser.h"
+#include "X86AdditionalInstrInfo.h"
 #include "llvm/Object/ELFObjectFile.h"
+#include <X86InstrBuilder.h>
+#include <X86Subtarget.h>
 
 using namespace llvm;
 
@@ -37,6 +41,82 @@ bool X86ModuleRaiser::collectDynamicRelocations() {
   return true;
 }
 
+// ld uses nop and lld uses int3 for alignment padding in text section.
+bool X86ModuleRaiser::isPaddingInstruction(const MCInst &Inst) const {
+  unsigned Opcode = Inst.getOpcode();
+  return mctoll::isNoop(Opcode) || (Opcode == X86::INT3);
+}
+
+// Opcodes not in X86AddlInstrInfo are not known either.
+bool X86ModuleRaiser::isUnknownOpcode(unsigned Opcode) const {
+  auto Iter = mctoll::X86AddlInstrInfo.find((uint16_t)Opcode);
+  return (Iter == mctoll::X86AddlInstrInfo.end()) ||
+         (Iter->second.InstKind == mctoll::InstructionKind::Unknown);
+}
+
+// Native code of a function can be bound to only if none of its decoded
+// instructions refers to an address by a RIP-relative memory operand, to an
+// address in a loaded section by an absolute memory or immediate operand, or
+// to a branch or call target outside the text section. Bytes that failed to
+// decode can not be checked.
+bool X86ModuleRaiser::canBindToNativeCode(MachineFunctionRaiser &MFR) const {
+  const ELF64LEObjectFile *Elf64LEObjFile = dyn_cast<ELF64LEObjectFile>(Obj);
+  if (!Elf64LEObjFile)
+    return false;
+
+  // Address ranges of sections loaded at run time, and the size of the text
+  // section
+  std::vector<std::pair<uint64_t, uint64_t>> LoadedRanges;
+  uint64_t TextSectionSize = 0;
+  for (ELFSectionRef Sec : Elf64LEObjFile->sections()) {
+    if (Sec.getIndex() == (unsigned)TextSectionIndex)
+      TextSectionSize = Sec.getSize();
+    if ((Sec.getFlags() & ELF::SHF_ALLOC) && (Sec.getSize() > 0))
+      LoadedRanges.emplace_back(Sec.getAddress(),
+                                Sec.getAddress() + Sec.getSize());
+  }
+  auto IsLoadedAddress = [&LoadedRanges](int64_t Imm) {
+    uint64_t Addr = (uint64_t)Imm;
+    return any_of(LoadedRanges, [Addr](std::pair<uint64_t, uint64_t> Range) {
+      return (Addr >= Range.first) && (Addr < Range.second);
+    });
+  };
+
+  MCInstRaiser *MCIR = MFR.getMCInstRaiser();
+  for (auto Iter = MCIR->const_mcinstr_begin();
+       Iter != MCIR->const_mcinstr_end(); Iter++) {
+    if (!Iter->second.isMCInst())
+      continue;
+    MCInst Inst = Iter->second.getMCInst();
+
+    // Branch and call targets are text section offsets, as are the indices
+    // of instructions.
+    if (MIA->isBranch(Inst) || MIA->isCall(Inst)) {
+      uint64_t Target;
+      if (MIA->evaluateBranch(Inst, Iter->first,
+                              MCIR->getMCInstSize(Iter->first), Target)) {
+        if (Target >= TextSectionSize)
+          return false;
+        continue;
+      }
+    }
+
+    const MCInstrDesc &Desc = MII->get(Inst.getOpcode());
+    int MemOpNo = X86II::getMemoryOperandNo(Desc.TSFlags);
+    if (MemOpNo >= 0) {
+      MemOpNo += X86II::getOperandBias(Desc);
+      const MCOperand &BaseOp = Inst.getOperand(MemOpNo + X86::AddrBaseReg);
+      if (BaseOp.isReg() && (BaseOp.getReg() == X86::RIP))
+        return false;
+    }
+
+    for (const MCOperand &Op : Inst)
+      if (Op.isImm() && IsLoadedAddress(Op.getImm()))
+        return false;
+  }
+  return true;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,6 +26,9 @@ public:
   CreateAndAddMachineFunctionRaiser(Function *F, const ModuleRaiser *MR,
                                     uint64_t Start, uint64_t End);
   bool collectDynamicRelocations();
+  bool isPaddingInstruction(const MCInst &Inst) const;
+  bool isUnknownOpcode(unsigned Opcode) const;
+  bool canBindToNativeCode(MachineFunctionRaiser &MFR) const;
 };
 
 #endif // LLVM_TOOLS_LLVM_MCTOLL_X86_X86MODULERAISER_H
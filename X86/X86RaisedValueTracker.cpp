@@ -24,6 +24,7 @@ using namespace X86RegisterUtils;
 X86RaisedValueTracker::X86RaisedValueTracker(
     X86MachineInstructionRaiser *MIRaiser) {
   x86MIRaiser = MIRaiser;
+  numEflagSSAValues = 0;
   // Initialize entries for function register arguments in physToValueMap
   // Only first 6 arguments are passed as registers
   unsigned RegArgCount = X86RegisterUtils::GPR64ArgRegs64Bit.size();
@@ -903,6 +904,7 @@ bool X86RaisedValueTracker::testAndSetEflagSSAValue(unsigned int FlagBit,
   }
   // EFLAGS bit size is 1
   physRegDefsInMBB[FlagBit][MBBNo].first = 1;
+  numEflagSSAValues++;
   return true;
 }
 
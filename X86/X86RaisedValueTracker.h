@@ -67,6 +67,8 @@ public:
   std::pair<int, Value *> getInBlockRegOrArgDefVal(unsigned int PhysReg,
                                                    int MBBNo);
   unsigned getInBlockPhysRegSize(unsigned int PhysReg, int MBBNo);
+  // Number of EFLAGS bit values computed from test results
+  unsigned getNumEflagSSAValues() const { return numEflagSSAValues; }
 
   enum { INVALID_MBB = -1 };
 
@@ -75,6 +77,7 @@ private:
   // Map of physical registers -> MBBNoToValueMap, representing per-block
   // register definitions.
   PhysRegMBBValueDefMap physRegDefsInMBB;
+  unsigned numEflagSSAValues;
 };
 
 #endif // LVM_TOOLS_LLVM_MCTOLL_X86_X86RAISEDVALUETRACKER_H
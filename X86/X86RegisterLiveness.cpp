@@ -0,0 +1,237 @@
+//===-- X86RegisterLiveness.cpp ---------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of X86RegisterLiveness class for use
+// by llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86RegisterLiveness.h"
+#include "X86RegisterUtils.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <X86Subtarget.h>
+
+using namespace X86RegisterUtils;
+
+// 64-bit general purpose registers tracked. EFLAGS bits are tracked at
+// indices following these.
+static const MCPhysReg TrackedGPR64Regs[] = {
+    X86::RAX, X86::RBX, X86::RCX, X86::RDX, X86::RSI, X86::RDI,
+    X86::RBP, X86::RSP, X86::R8,  X86::R9,  X86::R10, X86::R11,
+    X86::R12, X86::R13, X86::R14, X86::R15};
+
+static const unsigned NumTrackedGPR64Regs = array_lengthof(TrackedGPR64Regs);
+
+X86RegisterLiveness::X86RegisterLiveness(
+    X86MachineInstructionRaiser *MIRaiser) {
+  x86MIRaiser = MIRaiser;
+  MachineFunction &MF = x86MIRaiser->getMF();
+  for (MachineBasicBlock &MBB : MF)
+    computeBlockDefUses(MBB);
+  computeLiveness();
+}
+
+int X86RegisterLiveness::getRegIndex(unsigned Reg) const {
+  if (isEflagBit(Reg))
+    return NumTrackedGPR64Regs + getEflagBitIndex(Reg);
+
+  if (!(X86::GR8RegClass.contains(Reg) || X86::GR16RegClass.contains(Reg) ||
+        X86::GR32RegClass.contains(Reg) || X86::GR64RegClass.contains(Reg)))
+    return -1;
+
+  unsigned SuperReg = x86MIRaiser->find64BitSuperReg(Reg);
+  for (unsigned Index = 0; Index < NumTrackedGPR64Regs; Index++)
+    if (TrackedGPR64Regs[Index] == SuperReg)
+      return Index;
+  return -1;
+}
+
+unsigned X86RegisterLiveness::getIndexReg(int Index) const {
+  if ((unsigned)Index < NumTrackedGPR64Regs)
+    return TrackedGPR64Regs[Index];
+  return EFlagBits[Index - NumTrackedGPR64Regs];
+}
+
+bool X86RegisterLiveness::testReg(const BitVector &Regs, unsigned Reg) const {
+  int Index = getRegIndex(Reg);
+  return (Index >= 0) && Regs.test(Index);
+}
+
+void X86RegisterLiveness::getInstrDefUses(const MachineInstr &MI,
+                                          SmallVectorImpl<int> &Uses,
+                                          SmallVectorImpl<int> &Defs) const {
+  for (const MachineOperand &MO : MI.operands()) {
+    if (!MO.isReg())
+      continue;
+    unsigned Reg = MO.getReg();
+    SmallVectorImpl<int> &RegIndices = MO.isDef() ? Defs : Uses;
+    if (Reg == X86::EFLAGS) {
+      // Use or def of EFLAGS is a use or def of all its status flags.
+      for (auto Bit : EFlagBits)
+        RegIndices.push_back(getRegIndex(Bit));
+      continue;
+    }
+    int Index = getRegIndex(Reg);
+    if (Index >= 0)
+      RegIndices.push_back(Index);
+  }
+
+  // Argument registers of a call or tail call and the return register of a
+  // return are not operands of the instructions.
+  if (MI.isCall() || x86MIRaiser->isDirectTailCall(MI)) {
+    for (auto ArgReg : GPR64ArgRegs64Bit)
+      Uses.push_back(getRegIndex(ArgReg));
+  } else if (MI.isReturn()) {
+    Uses.push_back(getRegIndex(X86::RAX));
+  }
+}
+
+void X86RegisterLiveness::computeBlockDefUses(const MachineBasicBlock &MBB) {
+  unsigned NumTrackedRegs = NumTrackedGPR64Regs + EFlagBits.size();
+  BlockLiveness &BL = blockLiveness[MBB.getNumber()];
+  BL.Defs.resize(NumTrackedRegs);
+  BL.Uses.resize(NumTrackedRegs);
+  BL.DefsAfterLastCall.resize(NumTrackedRegs);
+  BL.LiveIn.resize(NumTrackedRegs);
+  BL.LiveOut.resize(NumTrackedRegs);
+  BL.HasCall = false;
+
+  SmallVector<int, 8> InstUses;
+  SmallVector<int, 8> InstDefs;
+  for (const MachineInstr &MI : MBB.instrs()) {
+    InstUses.clear();
+    InstDefs.clear();
+    getInstrDefUses(MI, InstUses, InstDefs);
+    for (int Index : InstUses)
+      if (!BL.Defs.test(Index))
+        BL.Uses.set(Index);
+    for (int Index : InstDefs)
+      BL.Defs.set(Index);
+
+    if (MI.isCall()) {
+      // Definitions of the call instruction are not considered to be
+      // after the call.
+      BL.HasCall = true;
+      BL.DefsAfterLastCall.reset();
+    } else {
+      for (int Index : InstDefs)
+        BL.DefsAfterLastCall.set(Index);
+    }
+  }
+}
+
+// Compute live-in and live-out sets of all blocks by iterating the backward
+// data flow equations
+//   LiveOut(B) = Union of LiveIn(S) for all successors S of B
+//   LiveIn(B)  = Uses(B) + (LiveOut(B) - Defs(B))
+// till a fixed point is reached. Blocks are visited in post order so that
+// successors are mostly visited before their predecessors.
+void X86RegisterLiveness::computeLiveness() {
+  MachineFunction &MF = x86MIRaiser->getMF();
+  if (MF.empty())
+    return;
+
+  // Blocks unreachable from entry are not visited by the post order walk.
+  std::vector<MachineBasicBlock *> WorkOrder;
+  SmallPtrSet<MachineBasicBlock *, 16> Reachable;
+  for (MachineBasicBlock *MBB : post_order(&MF)) {
+    WorkOrder.push_back(MBB);
+    Reachable.insert(MBB);
+  }
+  for (MachineBasicBlock &MBB : MF)
+    if (!Reachable.count(&MBB))
+      WorkOrder.push_back(&MBB);
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (MachineBasicBlock *MBB : WorkOrder) {
+      BlockLiveness &BL = blockLiveness[MBB->getNumber()];
+      for (MachineBasicBlock *Succ : MBB->successors())
+        BL.LiveOut |= blockLiveness[Succ->getNumber()].LiveIn;
+
+      BitVector NewLiveIn(BL.LiveOut);
+      NewLiveIn.reset(BL.Defs);
+      NewLiveIn |= BL.Uses;
+      if (NewLiveIn != BL.LiveIn) {
+        BL.LiveIn = NewLiveIn;
+        Changed = true;
+      }
+    }
+  }
+}
+
+bool X86RegisterLiveness::isDefinedInBlock(unsigned Reg, int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return testReg(Iter->second.Defs, Reg);
+}
+
+bool X86RegisterLiveness::isUsedInBlock(unsigned Reg, int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return testReg(Iter->second.Uses, Reg);
+}
+
+bool X86RegisterLiveness::isDefinedAfterLastCall(unsigned Reg,
+                                                 int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return testReg(Iter->second.DefsAfterLastCall, Reg);
+}
+
+bool X86RegisterLiveness::hasCall(int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return Iter->second.HasCall;
+}
+
+bool X86RegisterLiveness::isLiveIn(unsigned Reg, int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return testReg(Iter->second.LiveIn, Reg);
+}
+
+bool X86RegisterLiveness::isLiveOut(unsigned Reg, int MBBNo) const {
+  auto Iter = blockLiveness.find(MBBNo);
+  assert(Iter != blockLiveness.end() && "Unknown block number");
+  return testReg(Iter->second.LiveOut, Reg);
+}
+
+bool X86RegisterLiveness::isEflagsLiveIn(int MBBNo) const {
+  for (auto Bit : EFlagBits)
+    if (isLiveIn(Bit, MBBNo))
+      return true;
+  return false;
+}
+
+MCPhysRegSet X86RegisterLiveness::getDefsBeforeInstr(const MachineInstr &MI,
+                                                     bool &HasCall) const {
+  MCPhysRegSet DefRegs;
+  SmallVector<int, 8> InstUses;
+  SmallVector<int, 8> InstDefs;
+  HasCall = false;
+  // Walk backwards starting from the instruction before MI
+  const MachineBasicBlock *MBB = MI.getParent();
+  MachineBasicBlock::const_reverse_instr_iterator InstIter =
+      MI.getReverseIterator();
+  for (const MachineInstr &PrevMI :
+       make_range(++InstIter, MBB->instr_rend())) {
+    if (PrevMI.isCall()) {
+      HasCall = true;
+      break;
+    }
+    InstUses.clear();
+    InstDefs.clear();
+    getInstrDefUses(PrevMI, InstUses, InstDefs);
+    for (int Index : InstDefs)
+      DefRegs.insert(getIndexReg(Index));
+  }
+  return DefRegs;
+}
@@ -0,0 +1,83 @@
+//===-- X86RegisterLiveness.h -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of X86RegisterLiveness class for use by
+// llvm-mctoll.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_X86_X86REGISTERLIVENESS_H
+#define LLVM_TOOLS_LLVM_MCTOLL_X86_X86REGISTERLIVENESS_H
+
+#include "X86MachineInstructionRaiser.h"
+#include "llvm/ADT/BitVector.h"
+
+// This class computes register def-use and liveness information of all
+// blocks of a MachineFunction once, so that analyses of the function need
+// not scan the instructions of the blocks repeatedly. General purpose
+// registers are tracked as their 64-bit super-registers; EFLAGS is tracked
+// as individual status flags. A definition of a sub-register is considered
+// a definition of its 64-bit super-register.
+//
+// Calls and direct tail calls are considered to use all argument registers,
+// and returns to use the return register. So the live-in sets computed are conservative.
+
+class X86RegisterLiveness {
+public:
+  X86RegisterLiveness() = delete;
+  X86RegisterLiveness(X86MachineInstructionRaiser *);
+
+  // Is Reg (or its 64-bit super-register) defined in block MBBNo?
+  bool isDefinedInBlock(unsigned Reg, int MBBNo) const;
+  // Is Reg used in block MBBNo before being defined in the block?
+  bool isUsedInBlock(unsigned Reg, int MBBNo) const;
+  // Is Reg defined in block MBBNo after its last call instruction? If the
+  // block has no call instruction, this is the same as isDefinedInBlock().
+  bool isDefinedAfterLastCall(unsigned Reg, int MBBNo) const;
+  bool hasCall(int MBBNo) const;
+  // Is liveness of Reg tracked?
+  bool isTrackedReg(unsigned Reg) const { return getRegIndex(Reg) >= 0; }
+  bool isLiveIn(unsigned Reg, int MBBNo) const;
+  bool isLiveOut(unsigned Reg, int MBBNo) const;
+  // Is any of the status flags of EFLAGS live-in to block MBBNo?
+  bool isEflagsLiveIn(int MBBNo) const;
+  // Return the set of 64-bit registers and EFLAGS bits defined in the block
+  // of MI between the last call instruction preceding MI - or block entry,
+  // if there is none - and MI. HasCall is set if a call instruction precedes
+  // MI in the block.
+  MCPhysRegSet getDefsBeforeInstr(const MachineInstr &MI, bool &HasCall) const;
+
+private:
+  // Def-use and liveness information of a block. Each bit vector is indexed
+  // by the tracked register index.
+  struct BlockLiveness {
+    BitVector Defs;
+    // Registers used before being defined in the block.
+    BitVector Uses;
+    BitVector DefsAfterLastCall;
+    BitVector LiveIn;
+    BitVector LiveOut;
+    bool HasCall;
+  };
+
+  void computeBlockDefUses(const MachineBasicBlock &MBB);
+  void computeLiveness();
+  // Add the indices of registers used and defined by MI to Uses and Defs.
+  void getInstrDefUses(const MachineInstr &MI, SmallVectorImpl<int> &Uses,
+                       SmallVectorImpl<int> &Defs) const;
+  // Return the index of Reg in the bit vectors, or -1 if Reg is not tracked.
+  int getRegIndex(unsigned Reg) const;
+  unsigned getIndexReg(int Index) const;
+  bool testReg(const BitVector &Regs, unsigned Reg) const;
+
+  X86MachineInstructionRaiser *x86MIRaiser;
+  // Map of MBBNo -> BlockLiveness
+  std::map<int, BlockLiveness> blockLiveness;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_X86_X86REGISTERLIVENESS_H
@@ -13,6 +13,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "X86RegisterUtils.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Support/TargetRegistry.h"
+#include <memory>
 
 namespace X86RegisterUtils {
 // Unfortunately, tablegen does not have an interface to query
@@ -36,21 +39,70 @@ const vector<MCPhysReg> GPR64ArgRegs8Bit({X86::DIL, X86::SIL, X86::DL, X86::CL,
 const vector<EFLAGBit> EFlagBits({EFLAGS::CF, EFLAGS::PF, EFLAGS::AF,
                                   EFLAGS::ZF, EFLAGS::SF, EFLAGS::OF});
 
+// Build the table of properties of all physical registers and EFLAGS bits
+static std::vector<PhysRegInfo> buildPhysRegInfoTable() {
+  std::vector<PhysRegInfo> Table(EFLAGS::UNDEFINED + 1);
+
+  // Sizes of general purpose registers
+  const std::pair<unsigned, uint8_t> SizedRegClasses[] = {
+      {X86::GR64RegClassID, 64},
+      {X86::GR32RegClassID, 32},
+      {X86::GR16RegClassID, 16},
+      {X86::GR8RegClassID, 8}};
+  for (auto RegClass : SizedRegClasses)
+    for (MCPhysReg Reg : X86MCRegisterClasses[RegClass.first])
+      Table[Reg].SizeInBits = RegClass.second;
+
+  // Argument registers
+  for (auto ArgRegs : {&GPR64ArgRegs64Bit, &GPR64ArgRegs32Bit,
+                       &GPR64ArgRegs16Bit, &GPR64ArgRegs8Bit})
+    for (unsigned I = 0, E = ArgRegs->size(); I < E; I++)
+      Table[(*ArgRegs)[I]].ArgNumber = I + 1;
+
+  // 64-bit super registers of general purpose registers. Sub-registers are
+  // known only to the MCRegisterInfo of the target.
+  std::string Error;
+  Triple TT("x86_64-unknown-linux-gnu");
+  const Target *X86Target = TargetRegistry::lookupTarget(TT.str(), Error);
+  assert(X86Target != nullptr && "X86 target not registered");
+  std::unique_ptr<MCRegisterInfo> MRI(X86Target->createMCRegInfo(TT.str()));
+  for (MCPhysReg Reg64 : X86MCRegisterClasses[X86::GR64RegClassID])
+    for (MCSubRegIterator SubRegs(Reg64, MRI.get(), /*IncludeSelf=*/true);
+         SubRegs.isValid(); ++SubRegs) {
+      assert(Table[*SubRegs].SuperReg64 == X86::NoRegister &&
+             "Expect only one 64-bit super register");
+      Table[*SubRegs].SuperReg64 = Reg64;
+    }
+  Table[X86::FPSW].SuperReg64 = X86::FPSW;
+  Table[X86::FPCW].SuperReg64 = X86::FPCW;
+
+  // EFLAGS bits
+  for (unsigned I = 0, E = EFlagBits.size(); I < E; I++) {
+    PhysRegInfo &Info = Table[EFlagBits[I]];
+    Info.SizeInBits = 1;
+    Info.EflagBitIndex = I;
+    Info.SuperReg64 = EFlagBits[I];
+  }
+  return Table;
+}
+
+const PhysRegInfo &getPhysRegInfo(unsigned PReg) {
+  static const std::vector<PhysRegInfo> Table = buildPhysRegInfoTable();
+  static const PhysRegInfo UnknownRegInfo;
+  if (PReg >= Table.size())
+    return UnknownRegInfo;
+  return Table[PReg];
+}
+
 bool isEflagBit(unsigned RegNo) {
   return ((RegNo >= EFLAGS::CF) && (RegNo < EFLAGS::UNDEFINED));
 }
 
 int getEflagBitIndex(unsigned EFBit) {
   assert(isEflagBit(EFBit) && "Undefined EFLAGS bit");
-  int index = 0;
-  for (auto v : EFlagBits) {
-    if (v == EFBit)
-      return index;
-    else
-      index++;
-  }
-  assert(false && "Unknown EFLAGS bit");
-  return -1;
+  int Index = getPhysRegInfo(EFBit).EflagBitIndex;
+  assert((Index != -1) && "Unknown EFLAGS bit");
+  return Index;
 }
 
 string getEflagName(unsigned EFBit) {
@@ -80,48 +132,47 @@ string getEflagName(unsigned EFBit) {
 }
 
 bool is64BitPhysReg(unsigned int PReg) {
-  return X86MCRegisterClasses[X86::GR64RegClassID].contains(PReg);
+  return getPhysRegInfo(PReg).SizeInBits == 64;
 }
 
 bool is32BitPhysReg(unsigned int PReg) {
-  return X86MCRegisterClasses[X86::GR32RegClassID].contains(PReg);
+  return getPhysRegInfo(PReg).SizeInBits == 32;
 }
 
 bool is16BitPhysReg(unsigned int PReg) {
-  return X86MCRegisterClasses[X86::GR16RegClassID].contains(PReg);
+  return getPhysRegInfo(PReg).SizeInBits == 16;
 }
 
 bool is8BitPhysReg(unsigned int PReg) {
-  return X86MCRegisterClasses[X86::GR8RegClassID].contains(PReg);
+  return getPhysRegInfo(PReg).SizeInBits == 8;
 }
 
 unsigned int getPhysRegSizeInBits(unsigned int PReg) {
-  if (is64BitPhysReg(PReg))
-    return 64;
-  else if (is32BitPhysReg(PReg))
-    return 32;
-  else if (is16BitPhysReg(PReg))
-    return 16;
-  else if (is8BitPhysReg(PReg))
-    return 8;
-  else if (isEflagBit(PReg))
-    return 1;
-
-  llvm_unreachable("Unhandled physical register specified");
+  unsigned SizeInBits = getPhysRegInfo(PReg).SizeInBits;
+  if (SizeInBits == 0)
+    llvm_unreachable("Unhandled physical register specified");
+  return SizeInBits;
 }
-unsigned getArgumentReg(int Index, Type *Ty) {
-  llvm::LLVMContext &Ctx(Ty->getContext());
 
+unsigned getArgumentReg(int Index, Type *Ty) {
   // Note: any pointer is an address and hence uses a 64-bit register
-  if ((Ty == Type::getInt64Ty(Ctx)) || (Ty->isPointerTy())) {
+  unsigned SizeInBits = 0;
+  if (Ty->isPointerTy())
+    SizeInBits = 64;
+  else if (Ty->isIntegerTy())
+    SizeInBits = Ty->getIntegerBitWidth();
+
+  switch (SizeInBits) {
+  case 64:
     return GPR64ArgRegs64Bit[Index];
-  } else if (Ty == Type::getInt32Ty(Ctx)) {
+  case 32:
     return GPR64ArgRegs32Bit[Index];
-  } else if (Ty == Type::getInt16Ty(Ctx)) {
+  case 16:
     return GPR64ArgRegs16Bit[Index];
-  } else if (Ty == Type::getInt8Ty(Ctx)) {
+  case 8:
     return GPR64ArgRegs8Bit[Index];
+  default:
+    return 0;
   }
-  return 0;
 }
 } // namespace X86RegisterUtils
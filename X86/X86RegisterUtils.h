@@ -53,6 +53,27 @@ extern const vector<MCPhysReg> GPR64ArgRegs8Bit;
 //                                                    X86::R9});
 extern const vector<EFLAGBit> EFlagBits;
 
+// Properties of a physical register or EFLAGS bit. Properties of all
+// registers are held in a dense table indexed by register number, built once
+// from the X86 register descriptions upon first query. So each query is a
+// single table lookup.
+struct PhysRegInfo {
+  // Size in bits of a general purpose register, 1 for an EFLAGS bit and 0
+  // for any other register
+  uint8_t SizeInBits = 0;
+  // Number, starting at 1, of the argument passed in the register per the C
+  // calling convention. 0 if no argument is passed in the register.
+  uint8_t ArgNumber = 0;
+  // Index of an EFLAGS bit in EFlagBits. -1 for any other register.
+  int8_t EflagBitIndex = -1;
+  // The 64-bit general purpose register that contains the register. EFLAGS
+  // bits, FPSW and FPCW are their own super register. NoRegister for any
+  // other register.
+  MCPhysReg SuperReg64 = X86::NoRegister;
+};
+
+const PhysRegInfo &getPhysRegInfo(unsigned PReg);
+
 bool isEflagBit(unsigned RegNo);
 int getEflagBitIndex(unsigned EFBit);
 string getEflagName(unsigned EFBit);
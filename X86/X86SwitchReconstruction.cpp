@@ -0,0 +1,409 @@
+//===-- X86SwitchReconstruction.cpp -----------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of discovering switch statements that
+// compilers lower as decision trees of compare-and-branch blocks (typically
+// for sparse case values) and raising them as a single switch instruction.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86MachineInstructionRaiser.h"
+#include "X86RegisterLiveness.h"
+#include "X86RegisterUtils.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/Support/Debug.h"
+#include <X86InstrBuilder.h>
+#include <X86Subtarget.h>
+
+#define DEBUG_TYPE "mctoll"
+
+using namespace llvm;
+using namespace mctoll;
+using namespace X86RegisterUtils;
+
+namespace {
+
+// Smallest number of compare-and-branch blocks in a decision tree that is
+// worth raising as a switch.
+const unsigned MinDecisionTreeNodes = 3;
+// Largest depth of a decision tree walked.
+const unsigned MaxDecisionTreeDepth = 32;
+// Largest number of case values a single non-default target may have.
+const uint64_t MaxCaseValuesPerTarget = 64;
+// Largest number of case values of a raised switch.
+const uint64_t MaxSwitchCases = 512;
+
+// A block of the form
+//    cmp reg, imm (or test reg, reg)
+//    jcc target
+// with the conditional branch expressed as Pred (reg, imm).
+struct CompareBranchNode {
+  const MachineInstr *CompareMI;
+  unsigned Reg;
+  CmpInst::Predicate Pred;
+  APInt Imm;
+  MachineBasicBlock *TakenMBB;
+  MachineBasicBlock *FallThroughMBB;
+};
+
+// List of disjoint inclusive intervals [Lo, Hi] of values, compared as
+// unsigned values.
+using ValueIntervals = std::vector<std::pair<APInt, APInt>>;
+
+// Return the set of values of width C.getBitWidth() that satisfy Pred (V, C).
+ValueIntervals getICmpRegion(CmpInst::Predicate Pred, const APInt &C) {
+  ValueIntervals Region;
+  unsigned BitWidth = C.getBitWidth();
+  ConstantRange CR = ConstantRange::makeExactICmpRegion(Pred, C);
+  if (CR.isEmptySet())
+    return Region;
+  if (CR.isFullSet()) {
+    Region.emplace_back(APInt::getMinValue(BitWidth),
+                        APInt::getMaxValue(BitWidth));
+    return Region;
+  }
+  APInt Lo = CR.getLower();
+  APInt Hi = CR.getUpper() - 1;
+  if (Lo.ule(Hi))
+    Region.emplace_back(Lo, Hi);
+  else {
+    // Range wraps around in the unsigned domain.
+    Region.emplace_back(APInt::getMinValue(BitWidth), Hi);
+    Region.emplace_back(Lo, APInt::getMaxValue(BitWidth));
+  }
+  return Region;
+}
+
+ValueIntervals intersectIntervals(const ValueIntervals &A,
+                                  const ValueIntervals &B) {
+  ValueIntervals Result;
+  auto AIter = A.begin(), BIter = B.begin();
+  while (AIter != A.end() && BIter != B.end()) {
+    APInt Lo = APIntOps::umax(AIter->first, BIter->first);
+    APInt Hi = APIntOps::umin(AIter->second, BIter->second);
+    if (Lo.ule(Hi))
+      Result.emplace_back(Lo, Hi);
+    if (AIter->second.ult(BIter->second))
+      AIter++;
+    else
+      BIter++;
+  }
+  return Result;
+}
+
+// Return the number of values in Intervals, saturated to Limit + 1.
+uint64_t countValues(const ValueIntervals &Intervals, uint64_t Limit) {
+  uint64_t Count = 0;
+  for (auto &Interval : Intervals) {
+    APInt Diff = Interval.second - Interval.first;
+    if (Diff.uge(Limit))
+      return Limit + 1;
+    Count += Diff.getZExtValue() + 1;
+    if (Count > Limit)
+      return Limit + 1;
+  }
+  return Count;
+}
+
+// Map X86 condition code of a branch following cmp reg, imm to the
+// corresponding predicate. Return BAD_ICMP_PREDICATE if it can not be
+// expressed as a compare of reg and imm.
+CmpInst::Predicate getCompareBranchPredicate(X86::CondCode CC, bool IsTest) {
+  switch (CC) {
+  case X86::COND_E:
+    return CmpInst::Predicate::ICMP_EQ;
+  case X86::COND_NE:
+    return CmpInst::Predicate::ICMP_NE;
+  case X86::COND_L:
+    return CmpInst::Predicate::ICMP_SLT;
+  case X86::COND_LE:
+    return CmpInst::Predicate::ICMP_SLE;
+  case X86::COND_G:
+    return CmpInst::Predicate::ICMP_SGT;
+  case X86::COND_GE:
+    return CmpInst::Predicate::ICMP_SGE;
+  // test reg, reg clears CF. So unsigned conditions other than those testing
+  // ZF are not of interest.
+  case X86::COND_B:
+    return IsTest ? CmpInst::Predicate::BAD_ICMP_PREDICATE
+                  : CmpInst::Predicate::ICMP_ULT;
+  case X86::COND_BE:
+    return IsTest ? CmpInst::Predicate::ICMP_EQ
+                  : CmpInst::Predicate::ICMP_ULE;
+  case X86::COND_A:
+    return IsTest ? CmpInst::Predicate::ICMP_NE
+                  : CmpInst::Predicate::ICMP_UGT;
+  case X86::COND_AE:
+    return IsTest ? CmpInst::Predicate::BAD_ICMP_PREDICATE
+                  : CmpInst::Predicate::ICMP_UGE;
+  default:
+    return CmpInst::Predicate::BAD_ICMP_PREDICATE;
+  }
+}
+
+// Return the block reached from MBB upon skipping blocks that consist of only
+// an unconditional branch.
+MachineBasicBlock *skipUnconditionalBranchBlocks(MachineBasicBlock *MBB) {
+  SmallPtrSet<MachineBasicBlock *, 4> Visited;
+  while ((MBB->size() == 1) && MBB->instr_front().isUnconditionalBranch() &&
+         (MBB->succ_size() == 1) && Visited.insert(MBB).second)
+    MBB = *MBB->succ_begin();
+  return MBB;
+}
+
+// Walk the decision tree rooted at Node. Values is the set of values of the
+// compared register for which Node is reached. Record the numbers of non-root
+// tree blocks in InteriorMBBNos and the set of values for which each of the
+// blocks outside the tree is reached in LeafValues, keyed by block number.
+void walkDecisionTree(
+    const std::map<int, CompareBranchNode> &Nodes,
+    const CompareBranchNode &Node, const ValueIntervals &Values,
+    unsigned Depth, std::vector<int> &InteriorMBBNos,
+    std::map<int, ValueIntervals> &LeafValues) {
+  std::pair<MachineBasicBlock *, CmpInst::Predicate> Edges[] = {
+      {Node.TakenMBB, Node.Pred},
+      {Node.FallThroughMBB, CmpInst::getInversePredicate(Node.Pred)}};
+
+  for (auto &Edge : Edges) {
+    MachineBasicBlock *SuccMBB = Edge.first;
+    ValueIntervals SuccValues =
+        intersectIntervals(Values, getICmpRegion(Edge.second, Node.Imm));
+    // Nothing to do if the edge is never taken.
+    if (SuccValues.empty())
+      continue;
+
+    // SuccMBB is part of the tree if it compares the same register and is
+    // reached only from Node.
+    auto NodeIter = Nodes.find(SuccMBB->getNumber());
+    if ((NodeIter != Nodes.end()) && (SuccMBB->size() == 2) &&
+        (SuccMBB->pred_size() == 1) && (NodeIter->second.Reg == Node.Reg) &&
+        (Depth < MaxDecisionTreeDepth)) {
+      InteriorMBBNos.push_back(SuccMBB->getNumber());
+      walkDecisionTree(Nodes, NodeIter->second, SuccValues, Depth + 1,
+                       InteriorMBBNos, LeafValues);
+    } else {
+      MachineBasicBlock *LeafMBB = skipUnconditionalBranchBlocks(SuccMBB);
+      ValueIntervals &Leaf = LeafValues[LeafMBB->getNumber()];
+      Leaf.insert(Leaf.end(), SuccValues.begin(), SuccValues.end());
+    }
+  }
+}
+
+} // end anonymous namespace
+
+// Discover decision trees of compare-and-branch blocks that test a single
+// register against constant values. Such trees are typically generated by
+// compilers for switch statements with sparse case values. The tree is
+// raised as a switch instruction in the root block so that the backend can
+// lower it appropriately for the target.
+bool X86MachineInstructionRaiser::discoverDecisionTreeSwitches() {
+  // Blocks with compare and branch instructions used to check bounds of jump
+  // tables are raised along with the jump tables.
+  std::set<int> JumpTableMBBNos;
+  for (auto &JTInfo : jtList)
+    JumpTableMBBNos.insert(JTInfo.conditionMBB->getNumber());
+
+  // Collect all blocks that end with a compare of a register with a constant
+  // followed by a conditional branch.
+  std::map<int, CompareBranchNode> Nodes;
+  for (MachineBasicBlock &MBB : MF) {
+    if ((MBB.size() < 2) || (MBB.succ_size() != 2) ||
+        (JumpTableMBBNos.find(MBB.getNumber()) != JumpTableMBBNos.end()))
+      continue;
+
+    const MachineInstr &BranchMI = MBB.instr_back();
+    unsigned BranchOpc = BranchMI.getOpcode();
+    if ((BranchOpc != X86::JCC_1) && (BranchOpc != X86::JCC_2) &&
+        (BranchOpc != X86::JCC_4))
+      continue;
+
+    const MachineInstr *CompareMI = BranchMI.getPrevNode();
+    bool IsTest = false;
+    switch (CompareMI->getOpcode()) {
+    case X86::CMP8ri:
+    case X86::CMP16ri:
+    case X86::CMP16ri8:
+    case X86::CMP32ri:
+    case X86::CMP32ri8:
+    case X86::CMP64ri32:
+    case X86::CMP64ri8:
+      break;
+    case X86::TEST8rr:
+    case X86::TEST16rr:
+    case X86::TEST32rr:
+    case X86::TEST64rr:
+      IsTest = true;
+      break;
+    default:
+      continue;
+    }
+
+    const MachineOperand &RegOp = CompareMI->getOperand(0);
+    const MachineOperand &SrcOp = CompareMI->getOperand(1);
+    if (!RegOp.isReg())
+      continue;
+    if (IsTest ? (!SrcOp.isReg() || (SrcOp.getReg() != RegOp.getReg()))
+               : !SrcOp.isImm())
+      continue;
+
+    X86::CondCode CC = static_cast<X86::CondCode>(
+        BranchMI.getOperand(BranchMI.getDesc().getNumOperands() - 1).getImm());
+    CmpInst::Predicate Pred = getCompareBranchPredicate(CC, IsTest);
+    if (Pred == CmpInst::Predicate::BAD_ICMP_PREDICATE)
+      continue;
+
+    int64_t TakenMBBNo = getBranchTargetMBBNumber(BranchMI);
+    if (TakenMBBNo == -1)
+      continue;
+    MachineBasicBlock *TakenMBB = MF.getBlockNumbered(TakenMBBNo);
+    MachineBasicBlock *FallThroughMBB = nullptr;
+    for (MachineBasicBlock *Succ : MBB.successors())
+      if (Succ != TakenMBB)
+        FallThroughMBB = Succ;
+    if (FallThroughMBB == nullptr)
+      continue;
+
+    unsigned Reg = RegOp.getReg();
+    unsigned RegSzInBits = getPhysRegSizeInBits(Reg);
+    int64_t ImmVal = IsTest ? 0 : SrcOp.getImm();
+    CompareBranchNode Node = {CompareMI,
+                              Reg,
+                              Pred,
+                              APInt(RegSzInBits, ImmVal, true /* isSigned */),
+                              TakenMBB,
+                              FallThroughMBB};
+    Nodes.emplace(MBB.getNumber(), Node);
+  }
+
+  for (auto &NodeEntry : Nodes) {
+    int RootMBBNo = NodeEntry.first;
+    const CompareBranchNode &Root = NodeEntry.second;
+    // Skip blocks reached only from a tree node testing the same register.
+    // These are part of the tree rooted at that node.
+    MachineBasicBlock *RootMBB = MF.getBlockNumbered(RootMBBNo);
+    if ((RootMBB->size() == 2) && (RootMBB->pred_size() == 1)) {
+      auto PredIter = Nodes.find((*RootMBB->pred_begin())->getNumber());
+      if ((PredIter != Nodes.end()) && (PredIter->second.Reg == Root.Reg))
+        continue;
+    }
+
+    unsigned BitWidth = Root.Imm.getBitWidth();
+    ValueIntervals AllValues;
+    AllValues.emplace_back(APInt::getMinValue(BitWidth),
+                           APInt::getMaxValue(BitWidth));
+    std::vector<int> InteriorMBBNos;
+    std::map<int, ValueIntervals> LeafValues;
+    walkDecisionTree(Nodes, Root, AllValues, 0, InteriorMBBNos, LeafValues);
+
+    if (InteriorMBBNos.size() + 1 < MinDecisionTreeNodes)
+      continue;
+
+    // Blocks with more than MaxCaseValuesPerTarget values are only
+    // representable as the default target. Of the remaining, pick the one
+    // reached for the most values as the default target.
+    MachineBasicBlock *DefaultMBB = nullptr;
+    uint64_t DefaultValueCount = 0;
+    bool MultipleDefaults = false;
+    for (auto &Leaf : LeafValues) {
+      uint64_t Count = countValues(Leaf.second, MaxCaseValuesPerTarget);
+      if (Count > MaxCaseValuesPerTarget) {
+        MultipleDefaults = (DefaultValueCount > MaxCaseValuesPerTarget);
+        if (MultipleDefaults)
+          break;
+      }
+      if (Count > DefaultValueCount) {
+        DefaultMBB = MF.getBlockNumbered(Leaf.first);
+        DefaultValueCount = Count;
+      }
+    }
+    if (MultipleDefaults || (DefaultMBB == nullptr))
+      continue;
+
+    // Blocks subsumed by the switch are not raised. So EFLAGS values of tree
+    // blocks should not be used by any of the targets.
+    X86RegisterLiveness *RegLiveness = getRegisterLiveness();
+    bool EflagsUsed = false;
+    for (auto &Leaf : LeafValues)
+      EflagsUsed |= RegLiveness->isEflagsLiveIn(Leaf.first);
+    if (EflagsUsed)
+      continue;
+
+    DecisionTreeSwitchInfo SwitchInfo;
+    SwitchInfo.CompareMI = Root.CompareMI;
+    SwitchInfo.DefaultMBB = DefaultMBB;
+    for (auto &Leaf : LeafValues) {
+      MachineBasicBlock *LeafMBB = MF.getBlockNumbered(Leaf.first);
+      if (LeafMBB == DefaultMBB)
+        continue;
+      for (auto &Interval : Leaf.second) {
+        for (APInt CaseVal = Interval.first;; CaseVal++) {
+          SwitchInfo.Cases.emplace_back(CaseVal, LeafMBB);
+          if (CaseVal == Interval.second)
+            break;
+        }
+      }
+    }
+    if ((SwitchInfo.Cases.size() < MinDecisionTreeNodes - 1) ||
+        (SwitchInfo.Cases.size() > MaxSwitchCases))
+      continue;
+
+    // Order the cases by value for a deterministic switch instruction.
+    std::sort(SwitchInfo.Cases.begin(), SwitchInfo.Cases.end(),
+              [](const std::pair<APInt, MachineBasicBlock *> &A,
+                 const std::pair<APInt, MachineBasicBlock *> &B) {
+                return A.first.ult(B.first);
+              });
+
+    LLVM_DEBUG(dbgs() << "Decision tree switch with "
+                      << SwitchInfo.Cases.size() << " cases found in "
+                      << MF.getName() << " at bb." << RootMBBNo << "\n");
+    decisionTreeSwitches.emplace(RootMBBNo, SwitchInfo);
+    decisionTreeInteriorMBBNos.insert(InteriorMBBNos.begin(),
+                                      InteriorMBBNos.end());
+  }
+
+  return true;
+}
+
+bool X86MachineInstructionRaiser::isDecisionTreeInteriorMBB(int MBBNo) const {
+  return decisionTreeInteriorMBBNos.find(MBBNo) !=
+         decisionTreeInteriorMBBNos.end();
+}
+
+// Raise the conditional branch of the root block of a decision tree as a
+// switch instruction.
+bool X86MachineInstructionRaiser::raiseDecisionTreeSwitch(
+    ControlTransferInfo *CTRec) {
+  const MachineInstr *MI = CTRec->CandidateMachineInstr;
+  BasicBlock *CandBB = CTRec->CandidateBlock;
+  LLVMContext &Ctx(MF.getFunction().getContext());
+
+  auto SwitchIter = decisionTreeSwitches.find(MI->getParent()->getNumber());
+  assert(SwitchIter != decisionTreeSwitches.end() &&
+         "Decision tree information not found");
+  const DecisionTreeSwitchInfo &SwitchInfo = SwitchIter->second;
+
+  // The compared register is not modified in the tree. So its value at the
+  // compare instruction of the root block is the switch value.
+  Value *SwitchOnVal = getRegOperandValue(*SwitchInfo.CompareMI, 0);
+  assert(SwitchOnVal != nullptr &&
+         "Failed to get value of decision tree compare register");
+
+  SwitchInst *Inst =
+      SwitchInst::Create(SwitchOnVal, getRaisedBasicBlock(SwitchInfo.DefaultMBB),
+                         SwitchInfo.Cases.size());
+  for (auto &Case : SwitchInfo.Cases)
+    Inst->addCase(ConstantInt::get(Ctx, Case.first),
+                  getRaisedBasicBlock(Case.second));
+
+  CandBB->getInstList().push_back(Inst);
+  CTRec->Raised = true;
+  return true;
+}
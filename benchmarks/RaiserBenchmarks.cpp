@@ -0,0 +1,391 @@
+//===-- RaiserBenchmarks.cpp ------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains microbenchmarks of the components of llvm-mctoll that
+// are exercised for every instruction or function raised. Each benchmark is
+// parameterized by the size of its input and reports the fitted complexity,
+// so that complexity regressions show up as numbers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "FunctionFilter.h"
+#include "MCInstRaiser.h"
+#include "X86AdditionalInstrInfo.h"
+#include "X86MachineInstructionRaiser.h"
+#include "X86ModuleRaiser.h"
+#include "X86RaisedValueTracker.h"
+#include "llvm-mctoll.h"
+#include "benchmark/benchmark.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ObjectYAML/yaml2obj.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include <X86InstrBuilder.h>
+#include <X86Subtarget.h>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Definitions of llvm-mctoll.cpp referenced by the raisers
+namespace RaiserContext {
+SmallVector<ModuleRaiser *, 4> ModuleRaiserRegistry;
+} // namespace RaiserContext
+
+LLVM_ATTRIBUTE_NORETURN void llvm::report_error(Error E, StringRef File) {
+  logAllUnhandledErrors(std::move(E), errs(), "'" + File + "': ");
+  exit(1);
+}
+
+namespace {
+
+// Target, module and module raiser shared by all benchmarks
+struct X86RaiserEnv {
+  LLVMContext Ctx;
+  std::unique_ptr<TargetMachine> TM;
+  std::unique_ptr<Module> M;
+  std::unique_ptr<MachineModuleInfo> MMI;
+  std::unique_ptr<const MCInstrAnalysis> MIA;
+  const MCInstrInfo *MII;
+  X86ModuleRaiser MR;
+
+  X86RaiserEnv() {
+    LLVMInitializeX86TargetInfo();
+    LLVMInitializeX86Target();
+    LLVMInitializeX86TargetMC();
+
+    std::string Error;
+    const std::string TT = "x86_64-unknown-linux-gnu";
+    const Target *T = TargetRegistry::lookupTarget(TT, Error);
+    if (T == nullptr)
+      report_fatal_error("Failed to find target " + TT + " : " + Error);
+    TM.reset(T->createTargetMachine(TT, "", "", TargetOptions(), None));
+    M = std::make_unique<Module>("bench", Ctx);
+    M->setDataLayout(TM->createDataLayout());
+    MMI = std::make_unique<MachineModuleInfo>(
+        static_cast<LLVMTargetMachine *>(TM.get()));
+    MII = TM->getMCInstrInfo();
+    MIA.reset(T->createMCInstrAnalysis(MII));
+    MR.setModuleRaiserInfo(M.get(), TM.get(), MMI.get(), MIA.get(), MII,
+                           nullptr, nullptr);
+  }
+
+  // Create an empty MachineFunction of a new place holder function
+  MachineFunction &createMachineFunction(StringRef Name) {
+    FunctionType *FT = FunctionType::get(Type::getVoidTy(Ctx), false);
+    Function *F =
+        Function::Create(FT, GlobalValue::ExternalLinkage, Name, M.get());
+    return MMI->getOrCreateMachineFunction(*F);
+  }
+
+  void eraseMachineFunction(MachineFunction &MF) {
+    Function &F = MF.getFunction();
+    MMI->deleteMachineFunctionFor(F);
+    F.eraseFromParent();
+  }
+};
+
+X86RaiserEnv &getEnv() {
+  static X86RaiserEnv Env;
+  return Env;
+}
+
+// X86 instruction raiser of a MachineFunction built by a benchmark, rather
+// than from decoded instructions. The place holder function of MF is used as
+// the raised function.
+class BenchmarkX86Raiser : public X86MachineInstructionRaiser {
+public:
+  BenchmarkX86Raiser(MachineFunction &MF, const ModuleRaiser *MR)
+      : X86MachineInstructionRaiser(MF, MR, nullptr) {
+    raisedFunction = &MF.getFunction();
+  }
+};
+
+// Each block of the synthetic function moves an immediate to RAX and
+// conditionally branches over the following block.
+const uint64_t MovSize = 10;
+const uint64_t JccSize = 2;
+const uint64_t BlockSize = MovSize + JccSize;
+
+// Add the instructions and branch targets of a synthetic function with
+// NumBlocks blocks, followed by a return, to MCIR.
+void addSyntheticFunction(MCInstRaiser &MCIR, uint64_t NumBlocks) {
+  const uint64_t RetIndex = NumBlocks * BlockSize;
+  MCIR.addTarget(0);
+  for (uint64_t Block = 0; Block < NumBlocks; Block++) {
+    uint64_t Start = Block * BlockSize;
+    MCInst Mov;
+    Mov.setOpcode(X86::MOV64ri);
+    Mov.addOperand(MCOperand::createReg(X86::RAX));
+    Mov.addOperand(MCOperand::createImm(Block));
+    MCIR.addMCInstOrData(Start, Mov);
+
+    uint64_t Target = std::min(Start + 2 * BlockSize, RetIndex);
+    MCInst Jcc;
+    Jcc.setOpcode(X86::JCC_1);
+    Jcc.addOperand(MCOperand::createImm(Target - (Start + BlockSize)));
+    Jcc.addOperand(MCOperand::createImm(X86::COND_NE));
+    MCIR.addMCInstOrData(Start + MovSize, Jcc);
+    MCIR.addTarget(Start + BlockSize);
+    MCIR.addTarget(Target);
+  }
+  MCInst Ret;
+  Ret.setOpcode(X86::RETQ);
+  MCIR.addMCInstOrData(RetIndex, Ret);
+}
+
+// Build a CFG of NumDiamonds diamonds chained head to tail in MF. Only the
+// entry block defines RAX. Return the last block.
+MachineBasicBlock *buildDiamondChain(MachineFunction &MF,
+                                     unsigned NumDiamonds) {
+  const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
+  MachineBasicBlock *Head = MF.CreateMachineBasicBlock();
+  MF.push_back(Head);
+  BuildMI(*Head, Head->end(), DebugLoc(), TII->get(X86::MOV64ri), X86::RAX)
+      .addImm(1);
+  for (unsigned I = 0; I < NumDiamonds; I++) {
+    MachineBasicBlock *Left = MF.CreateMachineBasicBlock();
+    MF.push_back(Left);
+    MachineBasicBlock *Right = MF.CreateMachineBasicBlock();
+    MF.push_back(Right);
+    MachineBasicBlock *Join = MF.CreateMachineBasicBlock();
+    MF.push_back(Join);
+    Head->addSuccessor(Left);
+    Head->addSuccessor(Right);
+    Left->addSuccessor(Join);
+    Right->addSuccessor(Join);
+    Head = Join;
+  }
+  return Head;
+}
+
+// Return YAML of a relocatable object with NumSections data sections
+// followed by a text section with NumRelocs relocations, each against a
+// distinct symbol.
+std::string getObjectYAML(unsigned NumSections, unsigned NumRelocs) {
+  assert((NumRelocs > 0) && "Expected at least one relocation");
+  std::string YAML;
+  raw_string_ostream OS(YAML);
+  OS << "--- !ELF\n"
+        "FileHeader:\n"
+        "  Class:   ELFCLASS64\n"
+        "  Data:    ELFDATA2LSB\n"
+        "  Type:    ET_REL\n"
+        "  Machine: EM_X86_64\n"
+        "Sections:\n";
+  for (unsigned I = 0; I < NumSections; I++)
+    OS << "  - Name:  .data." << I << "\n"
+       << "    Type:  SHT_PROGBITS\n"
+       << "    Flags: [ SHF_ALLOC, SHF_WRITE ]\n"
+       << "    Size:  8\n";
+  OS << "  - Name:  .text\n"
+     << "    Type:  SHT_PROGBITS\n"
+     << "    Flags: [ SHF_ALLOC, SHF_EXECINSTR ]\n"
+     << "    Size:  " << NumRelocs * 4 << "\n"
+     << "  - Name:  .rela.text\n"
+     << "    Type:  SHT_RELA\n"
+     << "    Info:  .text\n"
+     << "    Relocations:\n";
+  for (unsigned I = 0; I < NumRelocs; I++)
+    OS << "      - Offset: " << I * 4 << "\n"
+       << "        Symbol: sym" << I << "\n"
+       << "        Type:   R_X86_64_PC32\n";
+  OS << "Symbols:\n";
+  for (unsigned I = 0; I < NumRelocs; I++)
+    OS << "  - Name:    sym" << I << "\n"
+       << "    Section: .text\n"
+       << "    Value:   " << I * 4 << "\n"
+       << "    Binding: STB_GLOBAL\n";
+  return OS.str();
+}
+
+// Relocatable object and a module raiser of it
+struct ObjectEnv {
+  SmallString<0> Storage;
+  std::unique_ptr<object::ObjectFile> Obj;
+  X86ModuleRaiser MR;
+
+  ObjectEnv(unsigned NumSections, unsigned NumRelocs) {
+    Obj = yaml::yaml2ObjectFile(Storage, getObjectYAML(NumSections, NumRelocs),
+                                [](const Twine &Msg) {
+                                  errs() << "**** Error : " << Msg << "\n";
+                                });
+    if (!Obj)
+      report_fatal_error("Failed to create object file to benchmark");
+
+    X86RaiserEnv &Env = getEnv();
+    MR.setModuleRaiserInfo(Env.M.get(), Env.TM.get(), Env.MMI.get(),
+                           Env.MIA.get(), Env.MII, Obj.get(), nullptr);
+    for (const object::SectionRef &Sec : Obj->sections()) {
+      Expected<StringRef> Name = Sec.getName();
+      if (!Name) {
+        consumeError(Name.takeError());
+        continue;
+      }
+      if (*Name == ".text") {
+        MR.collectTextSectionRelocs(Sec);
+        break;
+      }
+    }
+  }
+};
+
+// Build a function filter with NumFuncs included functions. Function I is
+// named filtered_I and starts at index 16 * I.
+void buildFunctionFilter(FunctionFilter &Filter, unsigned NumFuncs,
+                         std::vector<std::string> &Names) {
+  for (unsigned I = 0; I < NumFuncs; I++) {
+    Names.push_back("filtered_" + std::to_string(I));
+    std::string Prototype = "void " + Names.back() + "()";
+    StringRef PrototypeRef(Prototype);
+    Filter.addIncludedFunction(PrototypeRef);
+    StringRef Sym(Names.back());
+    Filter.findFuncInfoBySymbol(Sym, FunctionFilter::FILTER_INCLUDE)
+        ->StartIdx = 16 * I;
+  }
+}
+
+} // end anonymous namespace
+
+static void BM_AddMCInstOrData(benchmark::State &State) {
+  const uint64_t NumInsts = State.range(0);
+  MCInst Nop;
+  Nop.setOpcode(X86::NOOP);
+  for (auto _ : State) {
+    BumpPtrAllocator Allocator;
+    MCInstRaiser MCIR(0, NumInsts, Allocator);
+    for (uint64_t Index = 0; Index < NumInsts; Index++)
+      MCIR.addMCInstOrData(Index, Nop);
+    benchmark::DoNotOptimize(MCIR.const_mcinstr_begin());
+  }
+  State.SetItemsProcessed(State.iterations() * NumInsts);
+  State.SetComplexityN(NumInsts);
+}
+BENCHMARK(BM_AddMCInstOrData)->RangeMultiplier(4)->Range(64, 1 << 18)
+    ->Complexity();
+
+static void BM_BuildCFG(benchmark::State &State) {
+  X86RaiserEnv &Env = getEnv();
+  const uint64_t NumBlocks = State.range(0);
+  for (auto _ : State) {
+    State.PauseTiming();
+    BumpPtrAllocator Allocator;
+    MCInstRaiser MCIR(0, NumBlocks * BlockSize + 1, Allocator);
+    addSyntheticFunction(MCIR, NumBlocks);
+    MachineFunction &MF = Env.createMachineFunction("cfg");
+    State.ResumeTiming();
+
+    MCIR.buildCFG(MF, Env.MIA.get(), Env.MII, &Env.MR);
+
+    State.PauseTiming();
+    Env.eraseMachineFunction(MF);
+    State.ResumeTiming();
+  }
+  State.SetItemsProcessed(State.iterations() * NumBlocks);
+  State.SetComplexityN(NumBlocks);
+}
+BENCHMARK(BM_BuildCFG)->RangeMultiplier(4)->Range(16, 1 << 14)->Complexity();
+
+static void BM_GetReachingDef(benchmark::State &State) {
+  X86RaiserEnv &Env = getEnv();
+  const unsigned NumDiamonds = State.range(0);
+  MachineFunction &MF = Env.createMachineFunction("reaching_def");
+  int LastMBBNo = buildDiamondChain(MF, NumDiamonds)->getNumber();
+  BenchmarkX86Raiser Raiser(MF, &Env.MR);
+  {
+    X86RaisedValueTracker Tracker(&Raiser);
+    Tracker.setPhysRegSSAValue(X86::RAX, 0,
+                               ConstantInt::get(Type::getInt64Ty(Env.Ctx), 1));
+    // The definition in the entry block is the only one reaching the last
+    // block. So no stack promotion is done.
+    for (auto _ : State)
+      benchmark::DoNotOptimize(Tracker.getReachingDef(X86::RAX, LastMBBNo));
+  }
+  Env.eraseMachineFunction(MF);
+  State.SetComplexityN(NumDiamonds);
+}
+BENCHMARK(BM_GetReachingDef)->RangeMultiplier(4)->Range(4, 1 << 12)
+    ->Complexity();
+
+static void BM_GetInstructionKind(benchmark::State &State) {
+  const unsigned NumLookups = State.range(0);
+  std::vector<unsigned> Opcodes;
+  for (auto &Entry : mctoll::X86AddlInstrInfo)
+    Opcodes.push_back(Entry.first);
+  for (auto _ : State)
+    for (unsigned I = 0; I < NumLookups; I++)
+      benchmark::DoNotOptimize(
+          mctoll::getInstructionKind(Opcodes[I % Opcodes.size()]));
+  State.SetItemsProcessed(State.iterations() * NumLookups);
+  State.SetComplexityN(NumLookups);
+}
+BENCHMARK(BM_GetInstructionKind)->RangeMultiplier(8)->Range(64, 1 << 18)
+    ->Complexity();
+
+static void BM_FindFuncInfoBySymbol(benchmark::State &State) {
+  const unsigned NumFuncs = State.range(0);
+  FunctionFilter Filter(*getEnv().M);
+  std::vector<std::string> Names;
+  buildFunctionFilter(Filter, NumFuncs, Names);
+  unsigned Next = 0;
+  for (auto _ : State) {
+    StringRef Sym(Names[Next]);
+    benchmark::DoNotOptimize(
+        Filter.findFuncInfoBySymbol(Sym, FunctionFilter::FILTER_INCLUDE));
+    Next = (Next + 1) % NumFuncs;
+  }
+  State.SetComplexityN(NumFuncs);
+}
+BENCHMARK(BM_FindFuncInfoBySymbol)->RangeMultiplier(4)->Range(16, 1 << 12)
+    ->Complexity();
+
+static void BM_FindFunctionByIndex(benchmark::State &State) {
+  const unsigned NumFuncs = State.range(0);
+  FunctionFilter Filter(*getEnv().M);
+  std::vector<std::string> Names;
+  buildFunctionFilter(Filter, NumFuncs, Names);
+  unsigned Next = 0;
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(Filter.findFunctionByIndex(
+        16 * Next, FunctionFilter::FILTER_INCLUDE));
+    Next = (Next + 1) % NumFuncs;
+  }
+  State.SetComplexityN(NumFuncs);
+}
+BENCHMARK(BM_FindFunctionByIndex)->RangeMultiplier(4)->Range(16, 1 << 12)
+    ->Complexity();
+
+static void BM_GetTextRelocAtOffset(benchmark::State &State) {
+  const unsigned NumRelocs = State.range(0);
+  ObjectEnv ObjEnv(0, NumRelocs);
+  unsigned Next = 0;
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(ObjEnv.MR.getTextRelocAtOffset(4 * Next, 4));
+    Next = (Next + 1) % NumRelocs;
+  }
+  State.SetComplexityN(NumRelocs);
+}
+BENCHMARK(BM_GetTextRelocAtOffset)->RangeMultiplier(4)->Range(16, 1 << 14)
+    ->Complexity();
+
+static void BM_GetTextSectionAddress(benchmark::State &State) {
+  const unsigned NumSections = State.range(0);
+  ObjectEnv ObjEnv(NumSections, 1);
+  for (auto _ : State)
+    benchmark::DoNotOptimize(ObjEnv.MR.getTextSectionAddress());
+  State.SetComplexityN(NumSections);
+}
+BENCHMARK(BM_GetTextSectionAddress)->RangeMultiplier(4)->Range(4, 1 << 12)
+    ->Complexity();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Measure the throughput of llvm-mctoll raising a fixed corpus of binaries.
+
+The corpus consists of dhrystone and the self-contained smoke-test programs
+built at each of the requested optimization levels, the smoke-test input
+libraries, and any additional programs or prebuilt binaries specified. For
+each binary, wall time, functions and instructions raised per second, peak
+RSS and the fraction of functions raised are reported. Results are written as
+JSON and may be compared against those of an earlier run.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from corpus import find_tool, get_corpus_programs
+
+
+def get_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--mctoll', required=True,
+                        help='llvm-mctoll binary to measure')
+    parser.add_argument('--tools-dir', default=None,
+                        help='directory with clang and llvm-nm (default: PATH)')
+    parser.add_argument('--opt-levels', default='O0,O1,O2,O3',
+                        help='comma-separated optimization levels to build '
+                        'the corpus programs at')
+    parser.add_argument('--program', action='append', default=[],
+                        metavar='DIR',
+                        help='directory with the C sources of an additional '
+                        'program to build at each optimization level')
+    parser.add_argument('--binary', action='append', default=[],
+                        metavar='FILE',
+                        help='additional prebuilt binary to raise')
+    parser.add_argument('--work-dir', default=None,
+                        help='directory for the built and raised files '
+                        '(default: a temporary directory)')
+    parser.add_argument('--output', default='corpus-bench.json',
+                        help='JSON file to write the results to')
+    parser.add_argument('--baseline', default=None,
+                        help='JSON results of an earlier run to compare with')
+    parser.add_argument('--tolerance', type=float, default=10.0,
+                        help='percentage by which wall time may exceed the '
+                        'baseline before it is reported as a regression')
+    return parser.parse_args()
+
+
+def build_corpus(clang, programs, opt_levels, work_dir):
+    """Build programs at each optimization level. Return built binaries."""
+    binaries = []
+    for name, sources, flags, is_shared in programs:
+        for opt_level in opt_levels:
+            suffix = '.so' if is_shared else ''
+            binary = os.path.join(work_dir,
+                                  '%s-%s%s' % (name, opt_level, suffix))
+            cmd = [clang, '-' + opt_level, '-o', binary] + flags + sources
+            if is_shared:
+                cmd += ['-shared', '-fPIC']
+            result = subprocess.run(cmd, stdout=subprocess.DEVNULL,
+                                    stderr=subprocess.PIPE)
+            if result.returncode != 0:
+                print('**** Warning : Failed to build %s at -%s, skipped' %
+                      (name, opt_level), file=sys.stderr)
+                continue
+            binaries.append(binary)
+    return binaries
+
+
+def count_functions(llvm_nm, binary):
+    """Return the number of functions defined in the text section."""
+    if llvm_nm is None:
+        return None
+    result = subprocess.run([llvm_nm, '--defined-only', binary],
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        return None
+    return sum(1 for line in result.stdout.splitlines()
+               if len(line.split()) == 3 and line.split()[1] in ('T', 't'))
+
+
+def read_metrics(metrics_file):
+    """Return the number of raised functions and their instructions."""
+    functions, instructions = 0, 0
+    if not os.path.exists(metrics_file):
+        return functions, instructions
+    with open(metrics_file) as f:
+        for line in f:
+            fields = line.rstrip('\n').split('\t')
+            if line.startswith('#') or len(fields) < 2:
+                continue
+            if fields[0] == '<module>':
+                instructions = int(fields[1])
+            else:
+                functions += 1
+    return functions, instructions
+
+
+def raise_binary(mctoll, llvm_nm, binary, work_dir):
+    base = os.path.join(work_dir, os.path.basename(binary))
+    metrics_file = base + '.metrics'
+    if os.path.exists(metrics_file):
+        os.remove(metrics_file)
+    cmd = [mctoll, '-d', '-raised-code-metrics=' + metrics_file,
+           '-o', base + '-dis.ll', binary]
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.DEVNULL)
+    # Wait using wait4 to get the resource usage of this run alone
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall_time = time.monotonic() - start
+    proc.returncode = status
+
+    functions_raised, instructions = read_metrics(metrics_file)
+    functions = count_functions(llvm_nm, binary)
+    rate = lambda count: count / wall_time if wall_time > 0 else 0.0
+    return {
+        'binary': os.path.basename(binary),
+        'success': os.WIFEXITED(status) and os.WEXITSTATUS(status) == 0,
+        'wall_time_s': round(wall_time, 4),
+        'functions': functions,
+        'functions_raised': functions_raised,
+        'function_success_rate':
+            round(functions_raised / functions, 4) if functions else None,
+        'instructions_raised': instructions,
+        'functions_per_s': round(rate(functions_raised), 2),
+        'instructions_per_s': round(rate(instructions), 2),
+        # ru_maxrss is in KiB on Linux
+        'peak_rss_kib': rusage.ru_maxrss,
+    }
+
+
+def summarize(results):
+    wall_time = sum(r['wall_time_s'] for r in results)
+    functions = sum(r['functions_raised'] for r in results)
+    instructions = sum(r['instructions_raised'] for r in results)
+    return {
+        'binaries': len(results),
+        'binaries_raised': sum(1 for r in results if r['success']),
+        'wall_time_s': round(wall_time, 4),
+        'functions_raised': functions,
+        'instructions_raised': instructions,
+        'functions_per_s': round(functions / wall_time, 2) if wall_time else 0,
+        'instructions_per_s':
+            round(instructions / wall_time, 2) if wall_time else 0,
+        'max_peak_rss_kib': max((r['peak_rss_kib'] for r in results),
+                                default=0),
+    }
+
+
+def compare_with_baseline(results, baseline_file, tolerance):
+    """Print the change from baseline. Return the number of regressions."""
+    with open(baseline_file) as f:
+        baseline = {r['binary']: r for r in json.load(f)['results']}
+    regressions = 0
+    print('%-40s %12s %12s %8s' % ('binary', 'base time', 'time', 'change'))
+    for r in results:
+        base = baseline.get(r['binary'])
+        if base is None or base['wall_time_s'] == 0:
+            continue
+        change = 100.0 * (r['wall_time_s'] / base['wall_time_s'] - 1)
+        regressed = (change > tolerance) or (base['success'] and
+                                             not r['success'])
+        regressions += regressed
+        print('%-40s %12.4f %12.4f %7.1f%%%s' %
+              (r['binary'], base['wall_time_s'], r['wall_time_s'], change,
+               '  REGRESSION' if regressed else ''))
+    return regressions
+
+
+def main():
+    args = get_args()
+    clang = find_tool('clang', args.tools_dir)
+    if clang is None:
+        sys.exit('clang not found. Specify its directory with --tools-dir')
+    llvm_nm = find_tool('llvm-nm', args.tools_dir)
+    if llvm_nm is None:
+        print('**** Warning : llvm-nm not found, function success rate is '
+              'not reported', file=sys.stderr)
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix='mctoll-corpus-')
+    os.makedirs(work_dir, exist_ok=True)
+
+    opt_levels = [level for level in args.opt_levels.split(',') if level]
+    binaries = build_corpus(clang, get_corpus_programs(args.program),
+                            opt_levels, work_dir)
+    binaries += args.binary
+
+    results = []
+    for binary in binaries:
+        result = raise_binary(args.mctoll, llvm_nm, binary, work_dir)
+        print('%-40s %s %8.4fs %6d functions %8d instructions %8d KiB' %
+              (result['binary'], 'ok  ' if result['success'] else 'FAIL',
+               result['wall_time_s'], result['functions_raised'],
+               result['instructions_raised'], result['peak_rss_kib']))
+        results.append(result)
+
+    report = {'mctoll': os.path.realpath(args.mctoll),
+              'opt_levels': opt_levels,
+              'summary': summarize(results),
+              'results': results}
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2)
+    print('Results written to %s' % args.output)
+
+    if not args.work_dir:
+        shutil.rmtree(work_dir)
+    if args.baseline and compare_with_baseline(results, args.baseline,
+                                               args.tolerance):
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,64 @@
+"""Programs of the benchmark corpus shared by the benchmark scripts.
+
+The corpus consists of dhrystone, the self-contained smoke-test programs and
+the libraries the smoke tests are linked with, along with any additional
+programs specified.
+"""
+
+import os
+import re
+import shutil
+
+MCTOLL_DIR = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+DHRYSTONE_DIR = os.path.join(MCTOLL_DIR, 'test', 'dhrystone')
+SMOKE_TEST_DIR = os.path.join(MCTOLL_DIR, 'test', 'smoke_test')
+DHRYSTONE_FLAGS = ['-DTIME', '-DHZ=2133', '-DNOSTRUCTASSIGN', '-mno-sse']
+
+
+def find_tool(name, tools_dir):
+    if tools_dir:
+        path = os.path.join(tools_dir, name)
+        if os.access(path, os.X_OK):
+            return path
+    return shutil.which(name)
+
+
+def first_run_line(source):
+    with open(source) as f:
+        for line in f:
+            match = re.match(r'\s*//\s*RUN:\s*(.*)', line)
+            if match:
+                return match.group(1)
+    return ''
+
+
+def get_corpus_programs(extra_program_dirs, include_libraries=True):
+    """Return a list of (name, sources, flags, is_shared) of the programs."""
+    programs = [('dhrystone',
+                 [os.path.join(DHRYSTONE_DIR, 'dhry_main.c'),
+                  os.path.join(DHRYSTONE_DIR, 'dhry_funcs_mod.c')],
+                 DHRYSTONE_FLAGS, False)]
+    # Smoke tests that build an executable from the test source alone
+    for name in sorted(os.listdir(SMOKE_TEST_DIR)):
+        source = os.path.join(SMOKE_TEST_DIR, name)
+        if not name.endswith('.c'):
+            continue
+        run = first_run_line(source)
+        if not re.match(r'clang -o %t(-opt)? .*%s', run):
+            continue
+        flags = ['-mno-sse'] if '-mno-sse' in run.split() else []
+        programs.append((os.path.splitext(name)[0], [source], flags, False))
+    # Libraries the smoke tests are linked with
+    inputs_dir = os.path.join(SMOKE_TEST_DIR, 'Inputs')
+    if include_libraries:
+        for name in sorted(os.listdir(inputs_dir)):
+            if name.endswith('.c'):
+                programs.append(('lib' + os.path.splitext(name)[0],
+                                 [os.path.join(inputs_dir, name)], [], True))
+    for program_dir in extra_program_dirs:
+        sources = sorted(os.path.join(program_dir, name)
+                         for name in os.listdir(program_dir)
+                         if name.endswith('.c'))
+        programs.append((os.path.basename(os.path.normpath(program_dir)),
+                         sources, [], False))
+    return programs
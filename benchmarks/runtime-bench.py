@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""Compare the performance of raised binaries with that of the originals.
+
+Each program of the corpus - dhrystone, the self-contained smoke-test
+programs and any additional programs specified - is built, raised by
+llvm-mctoll and the raised IR recompiled, both at the same optimization
+level. The original and the recompiled binaries are run and their outputs
+compared. For each program, the ratio of the run time of the recompiled
+binary to that of the original and the ratio of the sizes of their text
+sections are reported. Results are written as JSON and may be compared
+against those of an earlier run.
+
+Smoke-test programs run for a few milliseconds, so their run time ratios
+mostly reflect process start up. Ratios of dhrystone and of larger programs
+specified with --program are the ones to watch.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+from corpus import find_tool, get_corpus_programs
+
+# Lines of output that vary from run to run and are not compared
+VARYING_OUTPUT = re.compile(r'Microseconds for one run|Dhrystones per Second')
+
+
+def get_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--mctoll', required=True,
+                        help='llvm-mctoll binary to raise programs with')
+    parser.add_argument('--tools-dir', default=None,
+                        help='directory with clang (default: PATH)')
+    parser.add_argument('--opt-level', default='O2',
+                        help='optimization level to build the original '
+                        'programs and to recompile the raised IR at')
+    parser.add_argument('--program', action='append', default=[],
+                        metavar='DIR',
+                        help='directory with the C sources of an additional '
+                        'program to measure')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='number of times to run each binary; the least '
+                        'run time is used')
+    parser.add_argument('--work-dir', default=None,
+                        help='directory for the built and raised files '
+                        '(default: a temporary directory)')
+    parser.add_argument('--output', default='runtime-bench.json',
+                        help='JSON file to write the results to')
+    parser.add_argument('--baseline', default=None,
+                        help='JSON results of an earlier run to compare with')
+    parser.add_argument('--tolerance', type=float, default=10.0,
+                        help='percentage by which the run time ratio may '
+                        'exceed that of the baseline before it is reported '
+                        'as a regression')
+    return parser.parse_args()
+
+
+def get_text_size(binary):
+    """Return the size of the .text section of ELF64 binary, or None."""
+    with open(binary, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF' or data[4] != 2 or data[5] != 1:
+        return None
+    shoff, = struct.unpack_from('<Q', data, 0x28)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x3a)
+    strtab_off, = struct.unpack_from('<Q', data,
+                                     shoff + shstrndx * shentsize + 0x18)
+    for index in range(shnum):
+        header = shoff + index * shentsize
+        name_off, = struct.unpack_from('<I', data, header)
+        name_end = data.index(b'\0', strtab_off + name_off)
+        if data[strtab_off + name_off:name_end] == b'.text':
+            size, = struct.unpack_from('<Q', data, header + 0x20)
+            return size
+    return None
+
+
+def run_binary(binary, repeat):
+    """Return the least run time of binary and its output, or None and the
+    error if it fails."""
+    least, output = None, None
+    for _ in range(repeat):
+        start = time.monotonic()
+        result = subprocess.run([binary], stdout=subprocess.PIPE,
+                                stderr=subprocess.STDOUT,
+                                universal_newlines=True,
+                                errors='replace')
+        run_time = time.monotonic() - start
+        if result.returncode < 0:
+            return None, 'killed by signal %d' % -result.returncode
+        least = run_time if least is None else min(least, run_time)
+        output = [line for line in result.stdout.splitlines()
+                  if not VARYING_OUTPUT.search(line)]
+    return least, output
+
+
+def build(cmd):
+    result = subprocess.run(cmd, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    return result.returncode == 0
+
+
+def measure_program(args, clang, program, work_dir):
+    name, sources, flags, _ = program
+    opt_flag = '-' + args.opt_level
+    original = os.path.join(work_dir, name)
+    raised_ir = original + '-dis.ll'
+    raised = original + '-dis'
+    result = {'benchmark': name, 'raised': False, 'output_matches': False}
+
+    if not build([clang, opt_flag, '-o', original] + flags + sources):
+        print('**** Warning : Failed to build %s, skipped' % name,
+              file=sys.stderr)
+        return None
+    result['original_text_bytes'] = get_text_size(original)
+    result['original_time_s'], original_output = run_binary(original,
+                                                            args.repeat)
+    if result['original_time_s'] is None:
+        print('**** Warning : %s failed to run: %s, skipped' %
+              (name, original_output), file=sys.stderr)
+        return None
+
+    if not (build([args.mctoll, '-d', '-o', raised_ir, original]) and
+            build([clang, opt_flag, '-o', raised, raised_ir])):
+        return result
+    result['raised'] = True
+    result['raised_text_bytes'] = get_text_size(raised)
+    result['raised_time_s'], raised_output = run_binary(raised, args.repeat)
+    if result['raised_time_s'] is None:
+        return result
+    result['output_matches'] = raised_output == original_output
+
+    if result['original_time_s'] > 0:
+        result['runtime_ratio'] = round(result['raised_time_s'] /
+                                        result['original_time_s'], 4)
+    if result['original_text_bytes'] and result['raised_text_bytes']:
+        result['code_size_ratio'] = round(result['raised_text_bytes'] /
+                                          result['original_text_bytes'], 4)
+    for key in ('original_time_s', 'raised_time_s'):
+        result[key] = round(result[key], 4)
+    return result
+
+
+def geomean(values):
+    values = [v for v in values if v]
+    if not values:
+        return None
+    return round(math.exp(sum(math.log(v) for v in values) / len(values)), 4)
+
+
+def summarize(results):
+    # Ratios of binaries whose output differs are not meaningful
+    correct = [r for r in results if r['output_matches']]
+    return {
+        'benchmarks': len(results),
+        'benchmarks_raised': sum(1 for r in results if r['raised']),
+        'outputs_matched': len(correct),
+        'geomean_runtime_ratio':
+            geomean(r.get('runtime_ratio') for r in correct),
+        'geomean_code_size_ratio':
+            geomean(r.get('code_size_ratio') for r in correct),
+    }
+
+
+def compare_with_baseline(results, baseline_file, tolerance):
+    """Print the change from baseline. Return the number of regressions."""
+    with open(baseline_file) as f:
+        baseline = {r['benchmark']: r for r in json.load(f)['results']}
+    regressions = 0
+    print('%-40s %12s %12s %8s' % ('benchmark', 'base ratio', 'ratio',
+                                   'change'))
+    for r in results:
+        base = baseline.get(r['benchmark'])
+        if base is None:
+            continue
+        if base['output_matches'] and not r['output_matches']:
+            regressions += 1
+            print('%-40s %12s %12s %8s  REGRESSION' %
+                  (r['benchmark'], 'correct', 'incorrect', ''))
+            continue
+        if not base.get('runtime_ratio') or not r.get('runtime_ratio'):
+            continue
+        change = 100.0 * (r['runtime_ratio'] / base['runtime_ratio'] - 1)
+        regressed = change > tolerance
+        regressions += regressed
+        print('%-40s %12.4f %12.4f %7.1f%%%s' %
+              (r['benchmark'], base['runtime_ratio'], r['runtime_ratio'],
+               change, '  REGRESSION' if regressed else ''))
+    return regressions
+
+
+def main():
+    args = get_args()
+    clang = find_tool('clang', args.tools_dir)
+    if clang is None:
+        sys.exit('clang not found. Specify its directory with --tools-dir')
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix='mctoll-runtime-')
+    os.makedirs(work_dir, exist_ok=True)
+
+    results = []
+    programs = get_corpus_programs(args.program, include_libraries=False)
+    for program in programs:
+        result = measure_program(args, clang, program, work_dir)
+        if result is None:
+            continue
+        if not result['raised']:
+            status = 'FAIL'
+        elif not result['output_matches']:
+            status = 'DIFF'
+        else:
+            status = 'ok  '
+        print('%-40s %s runtime ratio %8s code size ratio %8s' %
+              (result['benchmark'], status,
+               result.get('runtime_ratio', '-'),
+               result.get('code_size_ratio', '-')))
+        results.append(result)
+
+    report = {'mctoll': os.path.realpath(args.mctoll),
+              'opt_level': args.opt_level,
+              'summary': summarize(results),
+              'results': results}
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2)
+    print('Results written to %s' % args.output)
+
+    if not args.work_dir:
+        shutil.rmtree(work_dir)
+    if args.baseline and compare_with_baseline(results, args.baseline,
+                                               args.tolerance):
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -12,11 +12,18 @@
 
 #include "llvm-mctoll.h"
 #include "EmitRaisedOutputPass.h"
+#include "MCInstDecodeCache.h"
 #include "MCInstOrData.h"
 #include "MachineFunctionRaiser.h"
 #include "ModuleRaiser.h"
+#include "OpcodeCoverage.h"
+#include "PhaseTimes.h"
+#include "RaisedCodeMetrics.h"
+#include "RaisedModuleRunner.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
@@ -35,6 +42,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCDisassembler/MCDisassembler.h"
@@ -86,6 +94,11 @@
 using namespace llvm;
 using namespace object;
 
+#define DEBUG_TYPE "mctoll"
+
+STATISTIC(NumDecodeCacheLookups, "Number of decoded instruction cache lookups");
+STATISTIC(NumDecodeCacheHits, "Number of decoded instruction cache hits");
+
 static cl::OptionCategory LLVMMCToLLCategory("llvm-mctoll options");
 
 static cl::list<std::string> InputFilenames(cl::Positional,
@@ -201,6 +214,85 @@ cl::opt<bool>
 cl::opt<bool> PrintFaultMaps("fault-map-section",
                              cl::desc("Display contents of faultmap section"));
 
+static cl::opt<bool> UseDecodeCache(
+    "decode-cache",
+    cl::desc("Cache decoded instructions by instruction bytes to avoid "
+             "decoding repeated encodings (x86 only)"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::opt<unsigned> OutputBufferSize(
+    "output-buffer-size",
+    cl::desc("Size in KiB of the buffer used to write the raised output "
+             "(0 to use the default buffer size of the output stream)"),
+    cl::cat(LLVMMCToLLCategory), cl::init(4096));
+
+static cl::opt<bool> VerifyRaisedFunctions(
+    "verify-raised-functions",
+    cl::desc("Verify each function as soon as it is raised and the raised "
+             "module once all functions are raised"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::opt<std::string> CoverageReport(
+    "coverage-report",
+    cl::desc("Write the per-opcode coverage of raised functions to the "
+             "specified file, adding to the counts of any existing report"),
+    cl::value_desc("filename"), cl::cat(LLVMMCToLLCategory));
+
+static cl::opt<std::string> RaisedCodeMetricsFile(
+    "raised-code-metrics",
+    cl::desc("Write metrics of the efficiency of raised code of each function "
+             "and of the module to the specified file ('-' for stdout)"),
+    cl::value_desc("filename"), cl::cat(LLVMMCToLLCategory));
+
+static cl::list<std::string> RaisedCodeMetricLimits(
+    "raised-code-metric-limit", cl::CommaSeparated,
+    cl::desc("Fail if a metric of the raised module exceeds its limit"),
+    cl::value_desc("metric=limit,..."), cl::cat(LLVMMCToLLCategory));
+
+static cl::opt<std::string> PhaseTimesFile(
+    "phase-times",
+    cl::desc("Write the time spent in each phase of raising to the specified "
+             "file ('-' for stdout)"),
+    cl::value_desc("filename"), cl::cat(LLVMMCToLLCategory));
+
+static cl::opt<bool> NativeFallback(
+    "native-fallback",
+    cl::desc("Raise functions that fail to decode, raise or verify as thunks "
+             "that call their native code copied into the raised module"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::opt<bool> CFGOnly(
+    "cfg-only",
+    cl::desc("Write the CFG of each function - blocks, control flow edges, "
+             "call sites and jump tables - as JSON instead of raising the "
+             "functions"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::opt<bool> LinkInputs(
+    "link-inputs",
+    cl::desc("Raise the executable specified as the first input and the "
+             "shared libraries it depends on, specified as the remaining "
+             "inputs in the order a linker searches them, into one module"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::opt<bool> RunRaised(
+    "run",
+    cl::desc("Run main of the raised module, compiled with ORC LLJIT, in "
+             "process once the module is written. Exit with the value main "
+             "returns"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
+static cl::list<std::string>
+    RunArgs("run-arg", cl::desc("Argument to main of the raised module run"),
+            cl::value_desc("argument"), cl::ZeroOrMore,
+            cl::cat(LLVMMCToLLCategory));
+
+static cl::opt<bool> ReleaseRaisedFunctions(
+    "release-raised-functions",
+    cl::desc("Release the machine function and decoded instructions of each "
+             "function as soon as it is raised"),
+    cl::cat(LLVMMCToLLCategory), cl::init(false));
+
 cl::opt<unsigned long long>
     StartAddress("start-address", cl::desc("Disassemble beginning at address"),
                  cl::value_desc("address"), cl::init(0));
@@ -444,18 +536,22 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
     else
       OutputFilename = IFN;
 
-    switch (OutputFormat) {
-    case CGFT_AssemblyFile:
-      OutputFilename += "-dis.ll";
-      break;
-    // Just uses enum CGFT_ObjectFile represent llvm bitcode file type
-    // provisionally.
-    case CGFT_ObjectFile:
-      OutputFilename += "-dis.bc";
-      break;
-    case CGFT_Null:
-      OutputFilename += ".null";
-      break;
+    if (CFGOnly) {
+      OutputFilename += "-cfg.json";
+    } else {
+      switch (OutputFormat) {
+      case CGFT_AssemblyFile:
+        OutputFilename += "-dis.ll";
+        break;
+      // Just uses enum CGFT_ObjectFile represent llvm bitcode file type
+      // provisionally.
+      case CGFT_ObjectFile:
+        OutputFilename += "-dis.bc";
+        break;
+      case CGFT_Null:
+        OutputFilename += ".null";
+        break;
+      }
     }
   }
 
@@ -821,12 +917,98 @@ ModuleRaiser *getModuleRaiser(const TargetMachine *tm) {
   return mr;
 }
 
+// Module raisers are registered anew for each input raised. Free those of the
+// input raised last, along with the raisers of its functions.
+void releaseModuleRaisers() {
+  for (auto m : ModuleRaiserRegistry)
+    delete m;
+  ModuleRaiserRegistry.clear();
+}
+
 } // namespace RaiserContext
 
+// Print the bytes of a data symbol in range [Start, End) of a text section
+// whose contents are Bytes, 8 bytes at a time.
+static void dumpTextSectionDataBytes(ArrayRef<uint8_t> Bytes,
+                                     uint64_t SectionAddr, uint64_t Start,
+                                     uint64_t End) {
+  uint8_t AsciiData[9] = {'\0'};
+  uint8_t Byte;
+  int NumBytes = 0;
+
+  for (uint64_t Index = Start; Index < End; Index += 1) {
+    if (((SectionAddr + Index) < StartAddress) ||
+        ((SectionAddr + Index) > StopAddress))
+      continue;
+    if (NumBytes == 0) {
+      outs() << format("%8" PRIx64 ":", SectionAddr + Index);
+      outs() << "\t";
+    }
+    Byte = Bytes.slice(Index)[0];
+    outs() << format(" %02x", Byte);
+    AsciiData[NumBytes] = isprint(Byte) ? Byte : '.';
+
+    uint8_t IndentOffset = 0;
+    NumBytes++;
+    if (Index == End - 1 || NumBytes > 8) {
+      // Indent the space for less than 8 bytes data.
+      // 2 spaces for byte and one for space between bytes
+      IndentOffset = 3 * (8 - NumBytes);
+      for (int Excess = 8 - NumBytes; Excess < 8; Excess++)
+        AsciiData[Excess] = '\0';
+      NumBytes = 8;
+    }
+    if (NumBytes == 8) {
+      AsciiData[8] = '\0';
+      outs() << std::string(IndentOffset, ' ') << "         ";
+      outs() << reinterpret_cast<char *>(AsciiData);
+      outs() << '\n';
+      NumBytes = 0;
+    }
+  }
+}
+
+// Write the time of each phase of raising, if requested
+static void writePhaseTimes(const PhaseTimes &Times) {
+  if (PhaseTimesFile.empty())
+    return;
+  std::error_code EC;
+  raw_fd_ostream TimesOS(PhaseTimesFile, EC, sys::fs::F_Text);
+  if (EC)
+    report_error(PhaseTimesFile, EC.message());
+  Times.print(TimesOS);
+}
+
+// Modules raised from all inputs share a context so that the modules raised
+// from shared libraries can be linked into that raised from the executable.
+static ManagedStatic<LLVMContext> RaisedModuleContext;
+// Modules raised from shared libraries, when -link-inputs is specified
+static ManagedStatic<std::vector<std::unique_ptr<Module>>> RaisedLibraryModules;
+
+// Link the modules raised from shared libraries into Dest, the module raised
+// from the executable. Only the definitions Dest references, directly or
+// through other linked definitions, are linked. Definitions of startup code
+// found in every input are thus not linked more than once.
+static void linkRaisedLibraryModules(Module &Dest) {
+  Linker L(Dest);
+  for (std::unique_ptr<Module> &LibModule : *RaisedLibraryModules) {
+    std::string LibName = LibModule->getModuleIdentifier();
+    if (L.linkInModule(std::move(LibModule), Linker::LinkOnlyNeeded))
+      report_error(LibName, "failed to link raised module");
+  }
+  RaisedLibraryModules->clear();
+}
+
+// Value returned by main of the raised module run, when -run is specified
+static int RaisedMainExitCode = EXIT_SUCCESS;
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   if (StartAddress > StopAddress)
     error("Start address should be less than stop address");
 
+  // Properties of the object that do not change while decoding its bytes
+  const bool IsArmElf = isArmElf(Obj);
+
   const Target *TheTarget = getTarget(Obj);
 
   // Package up features to be passed to target/subtarget
@@ -872,6 +1054,13 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   std::unique_ptr<const MCInstrAnalysis> MIA(
       TheTarget->createMCInstrAnalysis(MII.get()));
 
+  // Decoded instructions may be cached only if decoding is independent of the
+  // instruction address and decoder state.
+  Triple::ArchType Arch = Obj->getArch();
+  const bool CacheDecodedInsts =
+      UseDecodeCache && ((Arch == Triple::x86) || (Arch == Triple::x86_64));
+  MCInstDecodeCache DecodeCache;
+
   int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
   std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
       Triple(TripleName), AsmPrinterVariant, *AsmInfo, *MII, *MRI));
@@ -881,7 +1070,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   IP->setPrintImmHex(PrintImmHex);
   PrettyPrinter &PIP = selectPrettyPrinter(Triple(TripleName));
 
-  LLVMContext llvmCtx;
+  LLVMContext &llvmCtx = *RaisedModuleContext;
   std::unique_ptr<TargetMachine> Target(
       TheTarget->createTargetMachine(TripleName, MCPU, Features.getString(),
                                      TargetOptions(), /* RelocModel */ None));
@@ -891,13 +1080,19 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   MachineModuleInfoWrapperPass *machineModuleInfo =
       new MachineModuleInfoWrapperPass(&llvmTgtMach);
   /* New Module instance with file name */
-  Module module(Obj->getFileName(), llvmCtx);
+  std::unique_ptr<Module> RaisedModule =
+      std::make_unique<Module>(Obj->getFileName(), llvmCtx);
+  Module &module = *RaisedModule;
   /* Set datalayout of the module to be the same as LLVMTargetMachine */
   module.setDataLayout(Target->createDataLayout());
   machineModuleInfo->doInitialization(module);
   // Initialize all module raisers that are supported and are part of current
   // LLVM build.
   ModuleRaiser::InitializeAllModuleRaisers();
+  // Free the module raisers once this input is raised, so that raisers of
+  // earlier inputs do not outlive the MachineFunctions they refer to.
+  auto ModuleRaisersReleaser =
+      make_scope_exit([]() { RaiserContext::releaseModuleRaisers(); });
   // Get the module raiser for Target of the binary being raised
   ModuleRaiser *moduleRaiser = RaiserContext::getModuleRaiser(Target.get());
   assert((moduleRaiser != nullptr) && "Failed to build module raiser");
@@ -906,6 +1101,34 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
                                     &machineModuleInfo->getMMI(), MIA.get(),
                                     MII.get(), Obj, DisAsm.get());
 
+  // Calls and references of the executable to functions and variables of
+  // the shared libraries are resolved to their raised definitions.
+  const bool IsLibraryInput =
+      LinkInputs && (Obj->getFileName() != InputFilenames[0]);
+  if (LinkInputs && !IsLibraryInput) {
+    std::vector<const Module *> LibModules;
+    for (std::unique_ptr<Module> &LibModule : *RaisedLibraryModules)
+      LibModules.push_back(LibModule.get());
+    moduleRaiser->setLibraryModules(LibModules);
+  }
+
+  // Collect opcode coverage of raised functions, if requested
+  OpcodeCoverage Coverage;
+  moduleRaiser->setOpcodeCoverage(CoverageReport.empty() ? nullptr
+                                                         : &Coverage);
+
+  // Collect metrics of raised code, if requested
+  RaisedCodeMetrics Metrics;
+  bool CollectMetrics =
+      !RaisedCodeMetricsFile.empty() || !RaisedCodeMetricLimits.empty();
+  moduleRaiser->setRaisedCodeMetrics(CollectMetrics ? &Metrics : nullptr);
+
+  // Time phases of raising. Phases other than those run by the module raiser
+  // are always timed since doing so is cheap.
+  PhaseTimes Times;
+  moduleRaiser->setPhaseTimes(PhaseTimesFile.empty() ? nullptr : &Times);
+  Times.start("decode");
+
   // Collect dynamic relocations.
   moduleRaiser->collectDynamicRelocations();
 
@@ -993,6 +1216,9 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   for (std::pair<const SectionRef, SectionSymbolsTy> &SecSyms : AllSymbols)
     array_pod_sort(SecSyms.second.begin(), SecSyms.second.end());
 
+  // Set if any function fails to raise or verify. The raised module is not
+  // emitted in that case.
+  bool RaisingFailed = false;
   for (const SectionRef &Section : ToolSectionFilter(*Obj)) {
     if ((!Section.isText() || Section.isVirtual()))
       continue;
@@ -1012,7 +1238,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     SectionSymbolsTy &Symbols = AllSymbols[Section];
     std::vector<uint64_t> DataMappingSymsAddr;
     std::vector<uint64_t> TextMappingSymsAddr;
-    if (isArmElf(Obj)) {
+    if (IsArmElf) {
       for (const auto &Symb : Symbols) {
         uint64_t Address = std::get<0>(Symb);
         StringRef Name = std::get<1>(Symb);
@@ -1263,6 +1489,29 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       // Start new basic block at the symbol.
       branchTargetSet.insert(Start);
 
+      // If there is a data symbol inside an ELF text section, we are in a
+      // situation where we must print the data and not disassemble it.
+      // TODO : Get rid of the following code.
+      if (Obj->isELF() && std::get<2>(Symbols[si]) == ELF::STT_OBJECT &&
+          Section.isText()) {
+        dumpTextSectionDataBytes(Bytes, SectionAddr, Start, End);
+        FuncFilter->eraseFunctionBySymbol(std::get<1>(Symbols[si]),
+                                          FunctionFilter::FILTER_INCLUDE);
+        continue;
+      }
+
+      // AArch64 ELF binaries can interleave data and text in the same
+      // section. Mapping symbols in the symbol range are walked using cursors
+      // that move forward along with the decode index; so the checks are
+      // hoisted out of the decode loop below.
+      const bool HasDataMappingSyms =
+          IsArmElf && (std::get<2>(Symbols[si]) != ELF::STT_OBJECT) &&
+          !DataMappingSymsAddr.empty();
+      auto DataMapSymIter = std::lower_bound(DataMappingSymsAddr.begin(),
+                                             DataMappingSymsAddr.end(), Start);
+      auto TextMapSymIter = std::lower_bound(TextMappingSymsAddr.begin(),
+                                             TextMappingSymsAddr.end(), Start);
+
       for (Index = Start; Index < End; Index += Size) {
         MCInst Inst;
 
@@ -1273,16 +1522,17 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
           continue;
         }
 
-        // AArch64 ELF binaries can interleave data and text in the
-        // same section. We rely on the markers introduced to
-        // understand what we need to dump. If the data marker is within a
-        // function, it is denoted as a word/short etc
-        if (isArmElf(Obj) && std::get<2>(Symbols[si]) != ELF::STT_OBJECT) {
+        // We rely on the mapping symbols to understand what we need to dump.
+        // If the data marker is within a function, it is denoted as a
+        // word/short etc
+        if (HasDataMappingSyms) {
           uint64_t Stride = 0;
 
-          auto DAI = std::lower_bound(DataMappingSymsAddr.begin(),
-                                      DataMappingSymsAddr.end(), Index);
-          if (DAI != DataMappingSymsAddr.end() && *DAI == Index) {
+          while ((DataMapSymIter != DataMappingSymsAddr.end()) &&
+                 (*DataMapSymIter < Index))
+            ++DataMapSymIter;
+          if (DataMapSymIter != DataMappingSymsAddr.end() &&
+              *DataMapSymIter == Index) {
             // Switch to data.
             while (Index < End) {
               if (Index + 4 <= End) {
@@ -1320,68 +1570,36 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
               }
               Index += Stride;
 
-              auto TAI = std::lower_bound(TextMappingSymsAddr.begin(),
-                                          TextMappingSymsAddr.end(), Index);
-              if (TAI != TextMappingSymsAddr.end() && *TAI == Index)
+              while ((TextMapSymIter != TextMappingSymsAddr.end()) &&
+                     (*TextMapSymIter < Index))
+                ++TextMapSymIter;
+              if (TextMapSymIter != TextMappingSymsAddr.end() &&
+                  *TextMapSymIter == Index)
                 break;
             }
           }
         }
 
-        // If there is a data symbol inside an ELF text section and we are
-        // only disassembling text, we are in a situation where we must print
-        // the data and not disassemble it.
-        // TODO : Get rid of the following code in the if-block.
-        if (Obj->isELF() && std::get<2>(Symbols[si]) == ELF::STT_OBJECT &&
-            Section.isText()) {
-          // parse data up to 8 bytes at a time
-          uint8_t AsciiData[9] = {'\0'};
-          uint8_t Byte;
-          int NumBytes = 0;
-
-          for (Index = Start; Index < End; Index += 1) {
-            if (((SectionAddr + Index) < StartAddress) ||
-                ((SectionAddr + Index) > StopAddress))
-              continue;
-            if (NumBytes == 0) {
-              outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-              outs() << "\t";
-            }
-            Byte = Bytes.slice(Index)[0];
-            outs() << format(" %02x", Byte);
-            AsciiData[NumBytes] = isprint(Byte) ? Byte : '.';
-
-            uint8_t IndentOffset = 0;
-            NumBytes++;
-            if (Index == End - 1 || NumBytes > 8) {
-              // Indent the space for less than 8 bytes data.
-              // 2 spaces for byte and one for space between bytes
-              IndentOffset = 3 * (8 - NumBytes);
-              for (int Excess = 8 - NumBytes; Excess < 8; Excess++)
-                AsciiData[Excess] = '\0';
-              NumBytes = 8;
-            }
-            if (NumBytes == 8) {
-              AsciiData[8] = '\0';
-              outs() << std::string(IndentOffset, ' ') << "         ";
-              outs() << reinterpret_cast<char *>(AsciiData);
-              outs() << '\n';
-              NumBytes = 0;
-            }
-          }
-        }
-
         if (Index >= End)
           break;
 
         // Disassemble a real instruction or a data
-        bool Disassembled = DisAsm->getInstruction(
-            Inst, Size, Bytes.slice(Index), SectionAddr + Index, DebugOut,
-            CommentStream);
+        bool Disassembled = false;
+        if (CacheDecodedInsts &&
+            DecodeCache.lookup(Bytes.slice(Index), Inst, Size))
+          Disassembled = true;
+        else {
+          Disassembled = DisAsm->getInstruction(
+              Inst, Size, Bytes.slice(Index), SectionAddr + Index, DebugOut,
+              CommentStream);
+          if (CacheDecodedInsts && Disassembled && (Size != 0))
+            DecodeCache.insert(Bytes.slice(Index), Size, Inst);
+        }
         if (Size == 0)
           Size = 1;
 
         if (!Disassembled) {
+          mcInstRaiser->setUndecodedInsts(true);
           errs() << "**** Warning: Failed to decode instruction\n";
           PIP.printInst(*IP, Disassembled ? &Inst : nullptr,
                         Bytes.slice(Index, Size), SectionAddr + Index, outs(),
@@ -1442,7 +1660,17 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     for (auto target : branchTargetSet)
       curMFRaiser->getMCInstRaiser()->addTarget(target);
 
-    moduleRaiser->runMachineFunctionPasses();
+    // Merge compiler-split function fragments into their functions
+    moduleRaiser->mergeSplitFunctionFragments();
+
+    // With -cfg-only, functions are not raised. Their CFGs are written once
+    // all sections are decoded.
+    if (!CFGOnly) {
+      if (!moduleRaiser->runMachineFunctionPasses(
+              ReleaseRaisedFunctions, VerifyRaisedFunctions, NativeFallback))
+        RaisingFailed = true;
+      Times.start("decode");
+    }
 
     if (!FuncFilter->isFilterSetEmpty(FunctionFilter::FILTER_INCLUDE)) {
       errs() << "***** WARNING: The following include filter symbol(s) are not "
@@ -1450,6 +1678,66 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       FuncFilter->dump(FunctionFilter::FILTER_INCLUDE);
     }
   }
+  Times.stop();
+  moduleRaiser->setPhaseTimes(nullptr);
+
+  if (CFGOnly) {
+    std::unique_ptr<ToolOutputFile> Out = GetOutputStream(
+        TheTarget->getName(), Triple(TripleName).getOS(), ToolName.data());
+    if (!Out)
+      return;
+    Times.start("write-cfg");
+    moduleRaiser->writeCFG(Out->os());
+    Times.stop();
+    Out->keep();
+    writePhaseTimes(Times);
+    return;
+  }
+
+  // The module raised from a shared library is linked into that raised from
+  // the executable. Reports are of the executable alone.
+  if (IsLibraryInput) {
+    if (RaisingFailed)
+      report_error(Obj->getFileName(), "Failed to raise module");
+    RaisedLibraryModules->push_back(std::move(RaisedModule));
+    return;
+  }
+
+  if (!CoverageReport.empty()) {
+    if (!Coverage.writeReport(CoverageReport))
+      report_error(CoverageReport, "Failed to write coverage report");
+    moduleRaiser->setOpcodeCoverage(nullptr);
+  }
+
+  if (CollectMetrics) {
+    moduleRaiser->setRaisedCodeMetrics(nullptr);
+    if (!RaisedCodeMetricsFile.empty()) {
+      std::error_code EC;
+      raw_fd_ostream MetricsOS(RaisedCodeMetricsFile, EC, sys::fs::F_Text);
+      if (EC)
+        report_error(RaisedCodeMetricsFile, EC.message());
+      Metrics.print(MetricsOS);
+    }
+  }
+
+  if (CacheDecodedInsts) {
+    NumDecodeCacheLookups += DecodeCache.getNumLookups();
+    NumDecodeCacheHits += DecodeCache.getNumHits();
+    LLVM_DEBUG(dbgs() << "Decoded instruction cache: "
+                      << DecodeCache.getNumHits() << " hits in "
+                      << DecodeCache.getNumLookups() << " lookups\n");
+  }
+
+  // Reports are written even if raising failed, since they record the
+  // functions that failed to raise.
+  if (RaisingFailed)
+    report_error(Obj->getFileName(), "Failed to raise module");
+
+  if (LinkInputs) {
+    Times.start("link");
+    linkRaisedLibraryModules(module);
+    Times.stop();
+  }
 
   // Add the pass manager
   Triple TheTriple = Triple(TripleName);
@@ -1465,6 +1753,11 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   Out->keep();
 
   raw_pwrite_stream *OS = &Out->os();
+  // Raised output of large binaries runs into hundreds of MB. Writing it
+  // through a large buffer avoids a write to the output file for every few
+  // KB of output.
+  if (OutputBufferSize > 0)
+    OS->SetBufferSize(static_cast<size_t>(OutputBufferSize) * 1024);
 
   legacy::PassManager PM;
 
@@ -1499,7 +1792,44 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   }
 
   cl::PrintOptionValues();
+  Times.start("emit");
   PM.run(module);
+  Times.stop();
+
+  if (RunRaised) {
+    // Output of the raised program follows that of the raiser
+    outs().flush();
+    Times.start("run");
+    std::vector<std::string> Args(RunArgs.begin(), RunArgs.end());
+    Expected<int> ExitCode = runRaisedModule(module, Obj->getFileName(), Args);
+    Times.stop();
+    if (!ExitCode)
+      report_error(ExitCode.takeError(), Obj->getFileName());
+    RaisedMainExitCode = *ExitCode;
+  }
+
+  writePhaseTimes(Times);
+
+  // Check metrics of the raised module against their limits once the output
+  // is written, so that the offending output is available for inspection.
+  bool MetricLimitsExceeded = false;
+  for (StringRef MetricLimit : RaisedCodeMetricLimits) {
+    StringRef MetricName, LimitStr;
+    std::tie(MetricName, LimitStr) = MetricLimit.split('=');
+    double Limit, Value;
+    if (LimitStr.getAsDouble(Limit) ||
+        !Metrics.getModuleMetric(MetricName, Value))
+      report_error(Obj->getFileName(),
+                   "Invalid raised code metric limit " + MetricLimit);
+    if (Value > Limit) {
+      errs() << "**** Error : Raised code metric " << MetricName
+             << " of module is " << format("%.2f", Value)
+             << ", exceeds limit " << LimitStr << "\n";
+      MetricLimitsExceeded = true;
+    }
+  }
+  if (MetricLimitsExceeded)
+    report_error(Obj->getFileName(), "Raised code exceeds metric limits");
 }
 
 void llvm::PrintSectionHeaders(const ObjectFile *Obj) {
@@ -1827,7 +2157,18 @@ int main(int argc, char **argv) {
   Disassemble = true;
   FilterSections.addValue(".text");
 
-  std::for_each(InputFilenames.begin(), InputFilenames.end(), DumpInput);
+  if (RunRaised && CFGOnly)
+    error("-cfg-only can not be used with -run");
+
+  if (LinkInputs) {
+    if (CFGOnly)
+      error("-cfg-only can not be used with -link-inputs");
+    // Shared libraries are raised first so that the executable is raised
+    // against the modules raised from them.
+    std::for_each(InputFilenames.begin() + 1, InputFilenames.end(), DumpInput);
+    DumpInput(InputFilenames[0]);
+  } else
+    std::for_each(InputFilenames.begin(), InputFilenames.end(), DumpInput);
 
-  return EXIT_SUCCESS;
+  return RaisedMainExitCode;
 }
@@ -0,0 +1,117 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=NONATOMIC_LL %s
+# CHECK: xadd old 10 new 15
+# CHECK-NEXT: lock add 22
+# CHECK-NEXT: cmpxchg 22 -> 100
+# CHECK-NEXT: xchg 100 -> 7
+# CHECK-NEXT: lock sub borrow 1
+# CHECK_LL: fence seq_cst
+# CHECK_LL: atomicrmw add
+# CHECK_LL: fence seq_cst
+# CHECK_LL: fence seq_cst
+# CHECK_LL: atomicrmw add
+# CHECK_LL: fence seq_cst
+# CHECK_LL: fence seq_cst
+# CHECK_LL: cmpxchg
+# CHECK_LL: @llvm.usub.with.overflow.i32
+# CHECK_LL: fence seq_cst
+# CHECK_LL: atomicrmw xchg
+# CHECK_LL: fence seq_cst
+# CHECK_LL: fence seq_cst
+# CHECK_LL: atomicrmw sub
+# CHECK_LL: @llvm.usub.with.overflow.i32
+# NONATOMIC_LL-NOT: load atomic
+# NONATOMIC_LL-NOT: store atomic
+
+#
+# Implicitly locked and lock-prefixed memory operations are expected to be
+# raised as LLVM atomic instructions bracketed by fences, with CF and OF set
+# as per the arithmetic performed. Other memory accesses are left non-atomic.
+#
+
+        .text
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbx
+        # xadd: counter = 10; old value in %eax
+        movl	$10, counter(%rip)
+        movl	$5, %eax
+        lock
+        xaddl	%eax, counter(%rip)
+        movl	counter(%rip), %edx
+        movl	%eax, %esi
+        movabsq	$.L.str.xadd, %rdi
+        movb	$0, %al
+        callq	printf
+        # lock add: counter = 15 + 7
+        lock
+        addl	$7, counter(%rip)
+        movl	counter(%rip), %esi
+        movabsq	$.L.str.add, %rdi
+        movb	$0, %al
+        callq	printf
+        # cmpxchg: counter == 22, so it is set to 100
+        movl	$22, %eax
+        movl	$100, %ecx
+        lock
+        cmpxchgl	%ecx, counter(%rip)
+        movl	counter(%rip), %edx
+        movl	%eax, %esi
+        movabsq	$.L.str.cmpxchg, %rdi
+        movb	$0, %al
+        callq	printf
+        # xchg: counter = 7; old value in %ebx
+        movl	$7, %ebx
+        xchgl	%ebx, counter(%rip)
+        mfence
+        movl	counter(%rip), %edx
+        movl	%ebx, %esi
+        movabsq	$.L.str.xchg, %rdi
+        movb	$0, %al
+        callq	printf
+        # lock sub: 7 - 8 borrows, so CF is set
+        lock
+        subl	$8, counter(%rip)
+        setb	%al
+        movzbl	%al, %esi
+        movabsq	$.L.str.sub, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbx
+        retq
+.Lfunc_end0:
+        .size	main, .Lfunc_end0-main
+
+        .type	counter,@object
+        .data
+        .globl	counter
+        .p2align	2
+counter:
+        .long	0
+        .size	counter, 4
+
+        .type	.L.str.xadd,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str.xadd:
+        .asciz	"xadd old %d new %d\n"
+        .size	.L.str.xadd, 20
+.L.str.add:
+        .asciz	"lock add %d\n"
+        .size	.L.str.add, 13
+.L.str.cmpxchg:
+        .asciz	"cmpxchg %d -> %d\n"
+        .size	.L.str.cmpxchg, 18
+.L.str.xchg:
+        .asciz	"xchg %d -> %d\n"
+        .size	.L.str.xchg, 15
+.L.str.sub:
+        .asciz	"lock sub borrow %d\n"
+        .size	.L.str.sub, 20
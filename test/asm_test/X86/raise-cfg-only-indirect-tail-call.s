@@ -0,0 +1,46 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -cfg-only %t
+# RUN: FileCheck --input-file=%t-cfg.json %s
+# CHECK: {"name":"apply","start":[[APPLY:[0-9]+]],"end":{{[0-9]+}},"blocks":{{\[}}{"start":[[APPLY]],"end":{{[0-9]+}},"insts":3,"succs":[]}],"calls":[],"jump-tables":[]}
+
+#
+# With -cfg-only, an indirect tail call is expected to be written as a block
+# without successors and not to be taken for a branch through a jump table.
+#
+
+        .text
+        .globl	apply
+        .p2align	4, 0x90
+        .type	apply,@function
+apply:
+        movq	%rdi, %rax
+        movl	%esi, %edi
+        jmpq	*%rax
+.Lfunc_end0:
+        .size	apply, .Lfunc_end0-apply
+
+        .globl	negate
+        .p2align	4, 0x90
+        .type	negate,@function
+negate:
+        movl	%edi, %eax
+        negl	%eax
+        retq
+.Lfunc_end1:
+        .size	negate, .Lfunc_end1-negate
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        leaq	negate(%rip), %rdi
+        movl	$5, %esi
+        callq	apply
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
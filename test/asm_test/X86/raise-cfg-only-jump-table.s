@@ -0,0 +1,90 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -cfg-only %t
+# RUN: FileCheck --input-file=%t-cfg.json %s
+# CHECK: {"name":"select",
+# CHECK-SAME: {"start":[[SELECT_JT:[0-9]+]],"end":[[SELECT_C0:[0-9]+]],"insts":5,
+# CHECK-SAME: {"start":[[SELECT_C0]],"end":[[SELECT_C1:[0-9]+]],"insts":2,
+# CHECK-SAME: {"start":[[SELECT_C1]],"end":[[SELECT_C2:[0-9]+]],"insts":2,
+# CHECK-SAME: {"start":[[SELECT_C2]],"end":{{[0-9]+}},"insts":2,
+# CHECK-SAME: "jump-tables":{{\[}}{"block":[[SELECT_JT]],"targets":{{\[}}[[SELECT_C0]],[[SELECT_C1]],[[SELECT_C2]]]}]}
+# CHECK-SAME: {"name":"select_join",
+# CHECK-SAME: {"start":[[JOIN_JT:[0-9]+]],"end":[[JOIN_C0:[0-9]+]],"insts":4,
+# CHECK-SAME: {"start":[[JOIN_C0]],"end":[[JOIN_C1:[0-9]+]],"insts":2,
+# CHECK-SAME: "jump-tables":{{\[}}{"block":[[JOIN_JT]],"targets":{{\[}}[[JOIN_C0]],[[JOIN_C1]]]}]}
+
+#
+# With -cfg-only, jump tables are expected to be listed with the block that
+# branches through them, without the function being raised. The jump table
+# block of select_join has two predecessors and is not the lowering of a
+# bounds-checked switch.
+#
+
+        .text
+        .globl	select
+        .p2align	4, 0x90
+        .type	select,@function
+select:
+        cmpl	$2, %edi
+        ja	.LBB0_5
+        movl	%edi, %eax
+        leaq	.LJTI0_0(%rip), %rcx
+        movslq	(%rcx,%rax,4), %rax
+        addq	%rcx, %rax
+        jmpq	*%rax
+.LBB0_2:
+        movl	$10, %eax
+        retq
+.LBB0_3:
+        movl	$20, %eax
+        retq
+.LBB0_4:
+        movl	$30, %eax
+        retq
+.LBB0_5:
+        xorl	%eax, %eax
+        retq
+.Lfunc_end0:
+        .size	select, .Lfunc_end0-select
+
+        .globl	select_join
+        .p2align	4, 0x90
+        .type	select_join,@function
+select_join:
+        testl	%esi, %esi
+        je	.LBB1_2
+        xorl	%edi, %edi
+.LBB1_2:
+        leaq	.LJTI1_0(%rip), %rcx
+        movslq	(%rcx,%rdi,4), %rax
+        addq	%rcx, %rax
+        jmpq	*%rax
+.LBB1_3:
+        movl	$1, %eax
+        retq
+.LBB1_4:
+        movl	$2, %eax
+        retq
+.Lfunc_end1:
+        .size	select_join, .Lfunc_end1-select_join
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        movl	$1, %edi
+        callq	select
+        xorl	%eax, %eax
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
+
+        .section	.rodata,"a",@progbits
+        .p2align	2
+.LJTI0_0:
+        .long	.LBB0_2-.LJTI0_0
+        .long	.LBB0_3-.LJTI0_0
+        .long	.LBB0_4-.LJTI0_0
+.LJTI1_0:
+        .long	.LBB1_3-.LJTI1_0
+        .long	.LBB1_4-.LJTI1_0
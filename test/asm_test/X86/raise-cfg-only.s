@@ -0,0 +1,38 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -cfg-only %t
+# RUN: FileCheck --input-file=%t-cfg.json %s
+# RUN: not ls %t-dis.ll
+# CHECK: {"name":"clamp","start":[[CLAMP:[0-9]+]],"end":{{[0-9]+}},"blocks":{{\[}}{"start":[[CLAMP]],"end":[[THEN:[0-9]+]],"insts":3,"succs":{{\[}}[[JOIN:[0-9]+]],[[THEN]]]},{"start":[[THEN]],"end":[[JOIN]],"insts":1,"succs":{{\[}}[[JOIN]]]},{"start":[[JOIN]],"end":{{[0-9]+}},"insts":1,"succs":[]}],"calls":[],"jump-tables":[]}
+# CHECK-SAME: {"name":"main","start":{{[0-9]+}},"end":{{[0-9]+}},"blocks":{{\[}}{"start":{{[0-9]+}},"end":{{[0-9]+}},"insts":7,"succs":[]}],"calls":{{\[}}{"site":{{[0-9]+}},"target":[[CLAMP]],"callee":"clamp"}],"jump-tables":[]}
+
+#
+# With -cfg-only, blocks, control flow edges and call sites of functions are
+# expected to be written as JSON instead of the raised module.
+#
+
+        .text
+        .globl	clamp
+        .type	clamp,@function
+clamp:
+        movl	%edi, %eax
+        cmpl	$10, %edi
+        jle	.LBB0_2
+        movl	$10, %eax
+.LBB0_2:
+        retq
+.Lfunc_end0:
+        .size	clamp, .Lfunc_end0-clamp
+
+        .globl	main
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$20, %edi
+        callq	clamp
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
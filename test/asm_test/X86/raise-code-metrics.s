@@ -0,0 +1,42 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -raised-code-metrics=%t.metrics -raised-code-metric-limit=ir-per-machine-inst=100,inttoptr=100 %t
+# RUN: FileCheck --input-file=%t.metrics %s
+# RUN: not llvm-mctoll -d -raised-code-metric-limit=ir-per-machine-inst=0.1 %t 2>&1 | FileCheck --check-prefix=LIMIT %s
+# CHECK: # function{{[[:space:]]}}machine-insts{{[[:space:]]}}ir-insts{{[[:space:]]}}ir-per-machine-inst
+# CHECK-DAG: {{^}}add_three{{[[:space:]]}}3{{[[:space:]]}}
+# CHECK-DAG: {{^}}main{{[[:space:]]}}
+# CHECK: {{^}}<module>{{[[:space:]]}}
+# LIMIT: **** Error : Raised code metric ir-per-machine-inst of module is {{[0-9.]+}}, exceeds limit 0.1
+
+#
+# Metrics of raised code are reported per function and for the module. A run
+# is expected to fail if a metric of the module exceeds its specified limit.
+#
+
+        .text
+        .globl	add_three
+        .p2align	4, 0x90
+        .type	add_three,@function
+add_three:
+        leal	(%rdi,%rsi), %eax
+        addl	%edx, %eax
+        retq
+.Lfunc_end0:
+        .size	add_three, .Lfunc_end0-add_three
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$1, %edi
+        movl	$2, %esi
+        movl	$3, %edx
+        callq	add_three
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
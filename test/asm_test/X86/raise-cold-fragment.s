@@ -0,0 +1,67 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: double(21) = 42
+# CHECK-NEXT: double(-5) = -1
+# CHECK_LL-NOT: double_or_fail.cold
+
+#
+# Cold code of double_or_fail is split into the fragment double_or_fail.cold
+# placed in .text.unlikely. The fragment is expected to be raised as part of
+# double_or_fail.
+#
+
+        .section	.text.unlikely,"ax",@progbits
+        .type	double_or_fail.cold,@function
+double_or_fail.cold:
+        movl	$-1, %eax
+        jmp	.Ldouble_or_fail_ret
+        .size	double_or_fail.cold, .-double_or_fail.cold
+
+        .text
+        .globl	double_or_fail
+        .p2align	4, 0x90
+        .type	double_or_fail,@function
+double_or_fail:
+        testl	%edi, %edi
+        js	double_or_fail.cold
+        movl	%edi, %eax
+        addl	%edi, %eax
+.Ldouble_or_fail_ret:
+        retq
+.Lfunc_end0:
+        .size	double_or_fail, .Lfunc_end0-double_or_fail
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbx
+        movl	$21, %edi
+        callq	double_or_fail
+        movl	%eax, %edx
+        movl	$21, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$-5, %edi
+        callq	double_or_fail
+        movl	%eax, %edx
+        movl	$-5, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbx
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"double(%d) = %d\n"
+        .size	.L.str, 17
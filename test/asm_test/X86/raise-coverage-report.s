@@ -0,0 +1,45 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: rm -f %t.cov
+# RUN: llvm-mctoll -d -coverage-report=%t.cov %t
+# RUN: llvm-mctoll -d -coverage-report=%t.cov %t
+# RUN: FileCheck --input-file=%t.cov %s
+# CHECK: # opcode{{[[:space:]]}}occurrences{{[[:space:]]}}unknown-kind{{[[:space:]]}}failed-functions{{[[:space:]]}}failed-function-bytes
+# CHECK: {{^}}IMUL32rr{{[[:space:]]}}2{{[[:space:]]}}no{{[[:space:]]}}0{{[[:space:]]}}0
+# RUN: echo "malformed" > %t-bad.cov
+# RUN: not llvm-mctoll -d -coverage-report=%t-bad.cov %t 2>&1 | FileCheck --check-prefix=BAD %s
+# RUN: FileCheck --check-prefix=BAD_COV --input-file=%t-bad.cov %s
+# BAD: **** Error : Malformed line in coverage report
+# BAD: Failed to write coverage report
+# BAD_COV: {{^}}malformed{{$}}
+
+#
+# Opcode coverage report written by two runs of the raiser on the same binary
+# is expected to accumulate the counts of both runs. A malformed existing
+# report is expected to fail the run and be left unchanged.
+#
+
+        .text
+        .globl	square
+        .p2align	4, 0x90
+        .type	square,@function
+square:
+        movl	%edi, %eax
+        imull	%edi, %eax
+        retq
+.Lfunc_end0:
+        .size	square, .Lfunc_end0-square
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$7, %edi
+        callq	square
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
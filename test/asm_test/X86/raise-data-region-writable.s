@@ -0,0 +1,51 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: slot 42 counter 7
+# CHECK_LL: @"RW-Section.data" = private global [{{[0-9]+}} x i8]
+# CHECK_LL-NOT: RO-Section.data
+
+#
+# Data of a writable section that has no symbol is expected to be raised as
+# offsets into a writable global with the contents of the section. Data
+# with a symbol is raised as the global of the symbol alone.
+#
+
+        .text
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$42, .Lslot(%rip)
+        addl	$4, counter(%rip)
+        movl	.Lslot(%rip), %esi
+        movl	counter(%rip), %edx
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end0:
+        .size	main, .Lfunc_end0-main
+
+        .data
+        .p2align	2
+.Lslot:
+        .long	1
+        .type	counter,@object
+        .globl	counter
+counter:
+        .long	3
+        .size	counter, 4
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"slot %d counter %d\n"
+        .size	.L.str, 20
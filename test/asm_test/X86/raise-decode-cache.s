@@ -0,0 +1,80 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -decode-cache %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# CHECK: sum 10 -> 55
+# CHECK-NEXT: twice 10 -> 110
+
+#
+# Functions with identical instruction encodings, including relative branches,
+# at different addresses. Instructions of the second function are expected to
+# be served from the decoded instruction cache and raised correctly.
+#
+
+        .text
+        .globl	sum
+        .p2align	4, 0x90
+        .type	sum,@function
+sum:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        xorl	%eax, %eax
+.LBB0_1:
+        addl	%edi, %eax
+        decl	%edi
+        jne	.LBB0_1
+        popq	%rbp
+        retq
+.Lfunc_end0:
+        .size	sum, .Lfunc_end0-sum
+
+        .globl	twice
+        .p2align	4, 0x90
+        .type	twice,@function
+twice:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        xorl	%eax, %eax
+.LBB1_1:
+        addl	%edi, %eax
+        addl	%edi, %eax
+        decl	%edi
+        jne	.LBB1_1
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	twice, .Lfunc_end1-twice
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$10, %edi
+        callq	sum
+        movl	%eax, %esi
+        movabsq	$.L.str.sum, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$10, %edi
+        callq	twice
+        movl	%eax, %esi
+        movabsq	$.L.str.twice, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
+
+        .type	.L.str.sum,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str.sum:
+        .asciz	"sum 10 -> %d\n"
+        .size	.L.str.sum, 14
+.L.str.twice:
+        .asciz	"twice 10 -> %d\n"
+        .size	.L.str.twice, 16
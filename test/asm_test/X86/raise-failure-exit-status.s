@@ -0,0 +1,41 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: rm -f %t-dis.ll
+# RUN: not llvm-mctoll -d %t 2>&1 | FileCheck %s
+# RUN: not test -e %t-dis.ll
+# CHECK: **** Error : Failed to raise function set_bit
+# CHECK: Failed to raise module
+
+#
+# A function that fails to raise is expected to fail the run without the
+# raised module being written.
+#
+
+        .text
+        .globl	set_bit
+        .p2align	4, 0x90
+        .type	set_bit,@function
+set_bit:
+        lock
+        btsl	$0, counter(%rip)
+        retq
+.Lfunc_end0:
+        .size	set_bit, .Lfunc_end0-set_bit
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        callq	set_bit
+        xorl	%eax, %eax
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	counter,@object
+        .data
+        .globl	counter
+        .p2align	2
+counter:
+        .long	0
+        .size	counter, 4
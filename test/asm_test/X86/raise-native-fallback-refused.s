@@ -0,0 +1,78 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: rm -f %t-dis.ll
+# RUN: not llvm-mctoll -d -native-fallback %t 2>&1 | FileCheck %s
+# RUN: not test -e %t-dis.ll
+# CHECK: **** Error : Function load_counter can not be bound to native code
+# CHECK: **** Error : Function call_puts can not be bound to native code
+# CHECK: **** Error : Function load_table can not be bound to native code
+# CHECK-NOT: Binding it to native code
+# CHECK: Failed to raise module
+
+#
+# Functions that fail to decode are not bound to native code with
+# -native-fallback if their native code refers to addresses outside the text
+# section, by a RIP-relative memory operand, a call through the PLT or an
+# absolute address. Such native code would not run correctly from the copy
+# of the text section in the raised module, so the run is expected to fail.
+#
+
+        .text
+        .globl	load_counter
+        .p2align	4, 0x90
+        .type	load_counter,@function
+load_counter:
+        movl	counter(%rip), %eax
+        retq
+        .byte	0x06
+.Lfunc_end0:
+        .size	load_counter, .Lfunc_end0-load_counter
+
+        .globl	call_puts
+        .p2align	4, 0x90
+        .type	call_puts,@function
+call_puts:
+        pushq	%rax
+        callq	puts@PLT
+        popq	%rcx
+        retq
+        .byte	0x06
+.Lfunc_end1:
+        .size	call_puts, .Lfunc_end1-call_puts
+
+        .globl	load_table
+        .p2align	4, 0x90
+        .type	load_table,@function
+load_table:
+        movslq	%edi, %rax
+        movabsq	$table, %rcx
+        movl	(%rcx,%rax,4), %eax
+        retq
+        .byte	0x06
+.Lfunc_end2:
+        .size	load_table, .Lfunc_end2-load_table
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        xorl	%eax, %eax
+        retq
+.Lfunc_end3:
+        .size	main, .Lfunc_end3-main
+
+        .type	counter,@object
+        .data
+        .globl	counter
+        .p2align	2
+counter:
+        .long	0
+        .size	counter, 4
+
+        .type	table,@object
+        .globl	table
+        .p2align	2
+table:
+        .long	1
+        .long	2
+        .size	table, 8
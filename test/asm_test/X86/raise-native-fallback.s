@@ -0,0 +1,56 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -native-fallback %t 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck --check-prefix=EXEC %s
+# CHECK: Function undecodable not raised. Binding it to native code
+# CHECK-NOT: Function main not raised
+# CHECK_LL: .pushsection .mctoll.native.text,\22ax\22,@progbits
+# CHECK_LL: @[[TEXT:__mctoll_native_text\.[A-Za-z0-9_]+]] = external hidden constant [{{[0-9]+}} x i8]
+# CHECK_LL: define dso_local i32 @undecodable(
+# CHECK_LL: musttail call i32 bitcast (i8* getelementptr inbounds ([{{[0-9]+}} x i8], [{{[0-9]+}} x i8]* @[[TEXT]], i64 0, i64 {{[0-9]+}}) to i32 (
+# CHECK_LL: define dso_local i32 @main(
+# CHECK_LL: call i32 @undecodable(
+# EXEC: undecodable(41) = 42
+
+#
+# A function with bytes that fail to decode is not raised with
+# -native-fallback. It is raised as a thunk to its native code, which is
+# copied into the raised module, and the raised module runs.
+#
+
+        .text
+        .globl	undecodable
+        .p2align	4, 0x90
+        .type	undecodable,@function
+undecodable:
+        leal	1(%rdi), %eax
+        retq
+        .byte	0x06
+.Lfunc_end0:
+        .size	undecodable, .Lfunc_end0-undecodable
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$41, %edi
+        callq	undecodable
+        movl	%eax, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"undecodable(41) = %d\n"
+        .size	.L.str, 22
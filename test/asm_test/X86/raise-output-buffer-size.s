@@ -0,0 +1,52 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -output-buffer-size=1 %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: llvm-mctoll -d -output-buffer-size=0 -output-format=bc %t
+# RUN: clang -o %t-dis-bc %t-dis.bc
+# RUN: %t-dis-bc 2>&1 | FileCheck %s
+# CHECK: max 3 9 -> 9
+
+#
+# Raised output written through a buffer of non-default size is expected to
+# be complete.
+#
+
+        .text
+        .globl	max
+        .p2align	4, 0x90
+        .type	max,@function
+max:
+        movl	%esi, %eax
+        cmpl	%esi, %edi
+        cmovgl	%edi, %eax
+        retq
+.Lfunc_end0:
+        .size	max, .Lfunc_end0-max
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$3, %edi
+        movl	$9, %esi
+        callq	max
+        movl	%eax, %edx
+        movl	$3, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"max %d 9 -> %d\n"
+        .size	.L.str, 16
@@ -0,0 +1,65 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# CHECK: sum 10 -> 55
+# CHECK-NEXT: sum 0 -> 0
+
+#
+# Alignment padding instructions are not raised. A branch whose target or
+# fall-through is a padding instruction is expected to reach the block of
+# the instruction following the padding.
+#
+
+        .text
+        .globl	sum
+        .p2align	4, 0x90
+        .type	sum,@function
+sum:
+        xorl	%eax, %eax
+        testl	%edi, %edi
+        jle	.LBB0_3
+        .p2align	4, 0x90
+.LBB0_1:
+        addl	%edi, %eax
+        decl	%edi
+        jne	.LBB0_1
+.LBB0_3:
+        retq
+        .p2align	4, 0xcc
+.Lfunc_end0:
+        .size	sum, .Lfunc_end0-sum
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$10, %edi
+        callq	sum
+        movl	%eax, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$0, %edi
+        callq	sum
+        movl	%eax, %esi
+        movabsq	$.L.str.1, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"sum 10 -> %d\n"
+        .size	.L.str, 14
+.L.str.1:
+        .asciz	"sum 0 -> %d\n"
+        .size	.L.str.1, 13
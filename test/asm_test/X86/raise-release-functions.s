@@ -0,0 +1,70 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -release-raised-functions %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# CHECK: square 7 -> 49
+# CHECK-NEXT: cube 3 -> 27
+
+#
+# State of each function is released once it is raised. Functions raised
+# later, including those calling already raised functions, are expected to
+# be raised correctly.
+#
+
+        .text
+        .globl	square
+        .p2align	4, 0x90
+        .type	square,@function
+square:
+        movl	%edi, %eax
+        imull	%edi, %eax
+        retq
+.Lfunc_end0:
+        .size	square, .Lfunc_end0-square
+
+        .globl	cube
+        .p2align	4, 0x90
+        .type	cube,@function
+cube:
+        pushq	%rbx
+        movl	%edi, %ebx
+        callq	square
+        imull	%ebx, %eax
+        popq	%rbx
+        retq
+.Lfunc_end1:
+        .size	cube, .Lfunc_end1-cube
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$7, %edi
+        callq	square
+        movl	%eax, %esi
+        movabsq	$.L.str.square, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$3, %edi
+        callq	cube
+        movl	%eax, %esi
+        movabsq	$.L.str.cube, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
+
+        .type	.L.str.square,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str.square:
+        .asciz	"square 7 -> %d\n"
+        .size	.L.str.square, 16
+.L.str.cube:
+        .asciz	"cube 3 -> %d\n"
+        .size	.L.str.cube, 14
@@ -0,0 +1,63 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: triple 7 -> 21
+# CHECK_LL: define dso_local i32 @triple_third
+# CHECK_LL: add i64 %{{.*}}, 8
+# CHECK_LL-NOT: add i64 %{{.*}}, 8
+# CHECK_LL: ret i32
+
+#
+# Repeated accesses to the same memory address expression in a block are
+# expected to reuse the address computation raised for the first access.
+#
+
+        .text
+        .globl	triple_third
+        .p2align	4, 0x90
+        .type	triple_third,@function
+triple_third:
+        movl	8(%rdi), %eax
+        addl	8(%rdi), %eax
+        addl	8(%rdi), %eax
+        retq
+.Lfunc_end0:
+        .size	triple_third, .Lfunc_end0-triple_third
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movabsq	$values, %rdi
+        callq	triple_third
+        movl	%eax, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	values,@object
+        .data
+        .globl	values
+        .p2align	2
+values:
+        .long	1
+        .long	3
+        .long	7
+        .long	9
+        .size	values, 16
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"triple 7 -> %d\n"
+        .size	.L.str, 16
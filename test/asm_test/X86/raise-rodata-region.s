@@ -0,0 +1,42 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: Hello, rodata
+# CHECK-NEXT: rodata
+# CHECK-NEXT: Hello, rodata
+# CHECK_LL: @"RO-Section.rodata" = private unnamed_addr constant [{{[0-9]+}} x i8]
+# CHECK_LL-NOT: RO-String
+
+#
+# Read-only data is expected to be raised as a single constant global with
+# the exact contents of .rodata. References to addresses in .rodata,
+# including those into the middle of a string, are raised as offsets into it.
+#
+
+        .text
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movabsq	$.L.str, %rdi
+        callq	puts
+        movabsq	$.L.str+7, %rdi
+        callq	puts
+        movabsq	$.L.str, %rdi
+        callq	puts
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end0:
+        .size	main, .Lfunc_end0-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"Hello, rodata"
+        .size	.L.str, 14
@@ -0,0 +1,90 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: sar -64 -> -16
+# CHECK-NEXT: shr 64 -> 32
+# CHECK-NEXT: inc 7 -> 8
+# CHECK_LL: ashr i32 %{{.*}}, 2
+# CHECK_LL: lshr i32 %{{.*}}, 1
+# CHECK_LL: add i32 %{{.*}}, 1
+
+#
+# Shift and increment instructions raised using the instruction semantics
+# table.
+#
+
+        .text
+        .globl	sar_two
+        .p2align	4, 0x90
+        .type	sar_two,@function
+sar_two:
+        movl	%edi, %eax
+        sarl	$2, %eax
+        retq
+.Lfunc_end0:
+        .size	sar_two, .Lfunc_end0-sar_two
+
+        .globl	shr_one
+        .p2align	4, 0x90
+        .type	shr_one,@function
+shr_one:
+        movl	%edi, %eax
+        shrl	%eax
+        retq
+.Lfunc_end1:
+        .size	shr_one, .Lfunc_end1-shr_one
+
+        .globl	inc_one
+        .p2align	4, 0x90
+        .type	inc_one,@function
+inc_one:
+        movl	%edi, %eax
+        incl	%eax
+        retq
+.Lfunc_end2:
+        .size	inc_one, .Lfunc_end2-inc_one
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$-64, %edi
+        callq	sar_two
+        movl	%eax, %esi
+        movabsq	$.L.str.sar, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$64, %edi
+        callq	shr_one
+        movl	%eax, %esi
+        movabsq	$.L.str.shr, %rdi
+        movb	$0, %al
+        callq	printf
+        movl	$7, %edi
+        callq	inc_one
+        movl	%eax, %esi
+        movabsq	$.L.str.inc, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end3:
+        .size	main, .Lfunc_end3-main
+
+        .type	.L.str.sar,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str.sar:
+        .asciz	"sar -64 -> %d\n"
+        .size	.L.str.sar, 15
+.L.str.shr:
+        .asciz	"shr 64 -> %d\n"
+        .size	.L.str.shr, 14
+.L.str.inc:
+        .asciz	"inc 7 -> %d\n"
+        .size	.L.str.inc, 13
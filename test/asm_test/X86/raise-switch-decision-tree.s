@@ -0,0 +1,105 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: 5 -> 10
+# CHECK-NEXT: 42 -> 20
+# CHECK-NEXT: 100 -> -1
+# CHECK-NEXT: 1000 -> 30
+# CHECK-NEXT: 4096 -> 40
+# CHECK-NEXT: -7 -> -1
+# CHECK_LL: switch i32 %arg1, label
+# CHECK_LL-NEXT: i32 5, label
+# CHECK_LL-NEXT: i32 42, label
+# CHECK_LL-NEXT: i32 1000, label
+# CHECK_LL-NEXT: i32 4096, label
+
+#
+# Sparse switch lowered as a binary search tree of compare-and-branch blocks.
+# The tree is expected to be raised as a single switch instruction.
+#
+
+        .text
+        .globl	sparse_switch
+        .p2align	4, 0x90
+        .type	sparse_switch,@function
+sparse_switch:
+        cmpl	$100, %edi
+        jg	.LBB0_4
+        cmpl	$5, %edi
+        je	.LBB0_7
+        cmpl	$42, %edi
+        je	.LBB0_8
+        jmp	.LBB0_11
+.LBB0_4:
+        cmpl	$1000, %edi
+        je	.LBB0_9
+        cmpl	$4096, %edi
+        je	.LBB0_10
+        jmp	.LBB0_11
+.LBB0_7:
+        movl	$10, %eax
+        retq
+.LBB0_8:
+        movl	$20, %eax
+        retq
+.LBB0_9:
+        movl	$30, %eax
+        retq
+.LBB0_10:
+        movl	$40, %eax
+        retq
+.LBB0_11:
+        movl	$-1, %eax
+        retq
+.Lfunc_end0:
+        .size	sparse_switch, .Lfunc_end0-sparse_switch
+
+        .globl	print_switch
+        .p2align	4, 0x90
+        .type	print_switch,@function
+print_switch:
+        pushq	%rbx
+        movl	%edi, %ebx
+        callq	sparse_switch
+        movl	%ebx, %esi
+        movl	%eax, %edx
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        popq	%rbx
+        retq
+.Lfunc_end1:
+        .size	print_switch, .Lfunc_end1-print_switch
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$5, %edi
+        callq	print_switch
+        movl	$42, %edi
+        callq	print_switch
+        movl	$100, %edi
+        callq	print_switch
+        movl	$1000, %edi
+        callq	print_switch
+        movl	$4096, %edi
+        callq	print_switch
+        movl	$-7, %edi
+        callq	print_switch
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"%d -> %d\n"
+        .size	.L.str, 10
@@ -0,0 +1,60 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d %t
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# RUN: FileCheck --input-file=%t-dis.ll --check-prefix=CHECK_LL %s
+# CHECK: inc_first(10, 3) = 8
+# CHECK_LL: define dso_local {{.*}} @inc_first(i32 %arg1, i32 %arg2)
+
+#
+# inc_first passes its second argument through to subtract, to which it
+# tail calls, without otherwise using it. The argument is expected to be
+# discovered as live-in at the tail call.
+#
+
+        .text
+        .globl	subtract
+        .p2align	4, 0x90
+        .type	subtract,@function
+subtract:
+        movl	%edi, %eax
+        subl	%esi, %eax
+        retq
+.Lfunc_end0:
+        .size	subtract, .Lfunc_end0-subtract
+
+        .globl	inc_first
+        .p2align	4, 0x90
+        .type	inc_first,@function
+inc_first:
+        addl	$1, %edi
+        jmp	subtract
+.Lfunc_end1:
+        .size	inc_first, .Lfunc_end1-inc_first
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rax
+        movl	$10, %edi
+        movl	$3, %esi
+        callq	inc_first
+        movl	%eax, %esi
+        movl	$.L.str, %edi
+        xorl	%eax, %eax
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rcx
+        retq
+.Lfunc_end2:
+        .size	main, .Lfunc_end2-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"inc_first(10, 3) = %d\n"
+        .size	.L.str, 23
+
+        .section	".note.GNU-stack","",@progbits
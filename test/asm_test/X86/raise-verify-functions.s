@@ -0,0 +1,48 @@
+# REQUIRES: x86_64-linux
+# RUN: clang -o %t %s
+# RUN: llvm-mctoll -d -verify-raised-functions %t 2>&1 | FileCheck --allow-empty --check-prefix=VERIFY %s
+# RUN: clang -o %t-dis %t-dis.ll
+# RUN: %t-dis 2>&1 | FileCheck %s
+# VERIFY-NOT: failed verification
+# CHECK: abs -5 -> 5
+
+#
+# Each raised function, and the raised module, are expected to pass
+# verification.
+#
+
+        .text
+        .globl	absval
+        .p2align	4, 0x90
+        .type	absval,@function
+absval:
+        movl	%edi, %eax
+        negl	%eax
+        cmovll	%edi, %eax
+        retq
+.Lfunc_end0:
+        .size	absval, .Lfunc_end0-absval
+
+        .globl	main
+        .p2align	4, 0x90
+        .type	main,@function
+main:
+        pushq	%rbp
+        movq	%rsp, %rbp
+        movl	$-5, %edi
+        callq	absval
+        movl	%eax, %esi
+        movabsq	$.L.str, %rdi
+        movb	$0, %al
+        callq	printf
+        xorl	%eax, %eax
+        popq	%rbp
+        retq
+.Lfunc_end1:
+        .size	main, .Lfunc_end1-main
+
+        .type	.L.str,@object
+        .section	.rodata.str1.1,"aMS",@progbits,1
+.L.str:
+        .asciz	"abs -5 -> %d\n"
+        .size	.L.str, 14
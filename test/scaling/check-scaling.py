@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Check that the time llvm-mctoll takes to raise a program grows no faster
+than expected with the size of the program.
+
+Programs are generated by gen-scaling-input.py with one size parameter - the
+number of functions, blocks per function or global variables - scaled by
+each of the specified factors while the others are held at their base
+values. Each program is built and raised with -phase-times. The growth
+exponent of each phase of raising, and of the total, is the slope of the
+least squares fit of log(time) against log(size parameter). The check fails
+if the exponent of any phase exceeds its bound. Phases that take less than
+the minimum time at every size are not checked since their times are
+dominated by noise.
+"""
+
+import argparse
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+SCALING_DIR = os.path.dirname(os.path.realpath(__file__))
+GENERATOR = os.path.join(SCALING_DIR, 'gen-scaling-input.py')
+SIZE_PARAMS = ('functions', 'blocks', 'globals')
+
+
+def get_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--mctoll', required=True,
+                        help='llvm-mctoll binary to check')
+    parser.add_argument('--tools-dir', default=None,
+                        help='directory with clang (default: PATH)')
+    parser.add_argument('--scale', default='functions,blocks',
+                        help='comma-separated size parameters to scale, of '
+                        + ', '.join(SIZE_PARAMS))
+    parser.add_argument('--factors', default='1,2,4,8',
+                        help='comma-separated factors to scale each size '
+                        'parameter by')
+    parser.add_argument('--functions', type=int, default=100,
+                        help='base number of functions')
+    parser.add_argument('--blocks', type=int, default=20,
+                        help='base number of blocks per function')
+    parser.add_argument('--globals', type=int, default=50,
+                        help='base number of global variables')
+    parser.add_argument('--call-density', type=float, default=0.2,
+                        help='fraction of blocks that call a function')
+    parser.add_argument('--switch-density', type=float, default=0.1,
+                        help='fraction of blocks that contain a switch')
+    parser.add_argument('--opt-level', default='O0',
+                        help='optimization level to build programs at')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='number of times to raise each program; the '
+                        'least time of each phase is used')
+    parser.add_argument('--max-exponent', type=float, default=1.5,
+                        help='bound of the growth exponent of each phase')
+    parser.add_argument('--phase-bound', action='append', default=[],
+                        metavar='PHASE=EXPONENT',
+                        help='bound of the growth exponent of PHASE, '
+                        'overriding --max-exponent')
+    parser.add_argument('--min-time', type=float, default=0.05,
+                        help='time in seconds below which the time of a '
+                        'phase is considered noise')
+    parser.add_argument('--work-dir', default=None,
+                        help='directory for the generated, built and raised '
+                        'files (default: a temporary directory)')
+    return parser.parse_args()
+
+
+def find_tool(name, tools_dir):
+    if tools_dir:
+        path = os.path.join(tools_dir, name)
+        if os.access(path, os.X_OK):
+            return path
+    return shutil.which(name)
+
+
+def read_phase_times(times_file):
+    """Return a dict of the wall time of each phase."""
+    times = {}
+    with open(times_file) as f:
+        for line in f:
+            fields = line.rstrip('\n').split('\t')
+            if line.startswith('#') or len(fields) < 2:
+                continue
+            times[fields[0]] = float(fields[1])
+    return times
+
+
+def build_program(args, clang, params, work_dir):
+    name = '-'.join('%s%d' % (p[0], params[p]) for p in SIZE_PARAMS)
+    source = os.path.join(work_dir, name + '.c')
+    binary = os.path.join(work_dir, name)
+    subprocess.run([sys.executable, GENERATOR,
+                    '--functions', str(params['functions']),
+                    '--blocks', str(params['blocks']),
+                    '--globals', str(params['globals']),
+                    '--call-density', str(args.call_density),
+                    '--switch-density', str(args.switch_density),
+                    '-o', source], check=True)
+    subprocess.run([clang, '-' + args.opt_level, '-mno-sse', '-o', binary,
+                    source], check=True)
+    return binary
+
+
+def raise_program(args, binary):
+    """Return a dict of the least wall time of each phase and the total."""
+    times_file = binary + '.times'
+    least = {}
+    for _ in range(args.repeat):
+        start = time.monotonic()
+        subprocess.run([args.mctoll, '-d', '-phase-times=' + times_file,
+                        '-o', binary + '-dis.ll', binary],
+                       stdout=subprocess.DEVNULL, check=True)
+        times = read_phase_times(times_file)
+        times['total'] = time.monotonic() - start
+        for phase, seconds in times.items():
+            least[phase] = min(seconds, least.get(phase, seconds))
+    return least
+
+
+def fit_exponent(sizes, times):
+    """Return the slope of the least squares fit of log(times) against
+    log(sizes)."""
+    xs = [math.log(s) for s in sizes]
+    ys = [math.log(max(t, 1e-6)) for t in times]
+    mean_x = sum(xs) / len(xs)
+    mean_y = sum(ys) / len(ys)
+    var_x = sum((x - mean_x) ** 2 for x in xs)
+    cov_xy = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    return cov_xy / var_x
+
+
+def check_scaling(args, clang, param, factors, bounds, work_dir):
+    """Scale param by factors. Return the number of phases whose growth
+    exponent exceeds its bound."""
+    base = {p: getattr(args, p) for p in SIZE_PARAMS}
+    sizes, phase_times = [], []
+    for factor in factors:
+        params = dict(base)
+        params[param] = base[param] * factor
+        binary = build_program(args, clang, params, work_dir)
+        times = raise_program(args, binary)
+        print('%s=%d: %s' % (param, params[param],
+                             ' '.join('%s %.4fs' % (phase, seconds)
+                                      for phase, seconds in times.items())))
+        sizes.append(params[param])
+        phase_times.append(times)
+
+    failures = 0
+    for phase in phase_times[-1]:
+        times = [t.get(phase, 0.0) for t in phase_times]
+        if max(times) < args.min_time:
+            print('  %-12s skipped, takes less than %gs' %
+                  (phase, args.min_time))
+            continue
+        exponent = fit_exponent(sizes, times)
+        bound = bounds.get(phase, args.max_exponent)
+        exceeded = exponent > bound
+        failures += exceeded
+        print('  %-12s exponent %5.2f, bound %5.2f%s' %
+              (phase, exponent, bound, '  EXCEEDED' if exceeded else ''))
+    return failures
+
+
+def main():
+    args = get_args()
+    clang = find_tool('clang', args.tools_dir)
+    if clang is None:
+        sys.exit('clang not found. Specify its directory with --tools-dir')
+
+    params = [p for p in args.scale.split(',') if p]
+    for param in params:
+        if param not in SIZE_PARAMS:
+            sys.exit('Unknown size parameter %s' % param)
+        if getattr(args, param) < 1:
+            sys.exit('Base value of scaled parameter %s must be positive' %
+                     param)
+    factors = sorted(set(int(f) for f in args.factors.split(',') if f))
+    if len(factors) < 2 or factors[0] < 1:
+        sys.exit('At least two positive factors are needed to fit growth')
+    bounds = {}
+    for phase_bound in args.phase_bound:
+        phase, _, bound = phase_bound.partition('=')
+        bounds[phase] = float(bound)
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix='mctoll-scaling-')
+    os.makedirs(work_dir, exist_ok=True)
+    failures = 0
+    for param in params:
+        failures += check_scaling(args, clang, param, factors, bounds,
+                                  work_dir)
+    if not args.work_dir:
+        shutil.rmtree(work_dir)
+
+    if failures:
+        print('**** Error : Growth of %d phase(s) exceeds the bound' %
+              failures)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
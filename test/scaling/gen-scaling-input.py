@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Generate a C program of parameterized size to measure how raising scales.
+
+The program consists of the specified number of functions, each with the
+specified number of conditional blocks. Each block of a function may also
+call a function defined before it, access global variables and switch over
+a value, with the specified densities. Functions are non-static so that all
+of them are retained, and are raised, at any optimization level. main calls
+a fixed number of functions so that its size does not grow with that of the
+program. The program is deterministic and prints a checksum of the values
+computed, so that output of the program and that of its raised version may
+be compared.
+"""
+
+import argparse
+import random
+import sys
+
+# Number of functions main calls
+MAIN_CALLS = 8
+# Depth of calls beyond which functions do not call other functions, to
+# bound the run time of the program
+CALL_DEPTH = 2
+
+
+def get_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--functions', type=int, default=100,
+                        help='number of functions')
+    parser.add_argument('--blocks', type=int, default=20,
+                        help='number of conditional blocks per function')
+    parser.add_argument('--globals', type=int, default=50,
+                        help='number of global variables')
+    parser.add_argument('--call-density', type=float, default=0.2,
+                        help='fraction of blocks that call a function')
+    parser.add_argument('--switch-density', type=float, default=0.1,
+                        help='fraction of blocks that contain a switch')
+    parser.add_argument('--seed', type=int, default=0,
+                        help='seed of the choices made in generating code')
+    parser.add_argument('-o', '--output', default='-',
+                        help='file to write the program to (default: stdout)')
+    return parser.parse_args()
+
+
+def generate_block(rng, index, params):
+    """Return lines of a block of function index."""
+    num_globals = params.globals
+    lines = []
+    mask = 1 << rng.randrange(8)
+    if num_globals > 0:
+        addend = 'g%d' % rng.randrange(num_globals)
+    else:
+        addend = '%du' % rng.randrange(1, 256)
+    lines += ['  if (r & %du)' % mask,
+              '    r = r * %du + %s;' % (rng.randrange(3, 17, 2), addend),
+              '  else',
+              '    r ^= %du;' % rng.randrange(1, 1 << 16)]
+    if index > 0 and rng.random() < params.call_density:
+        callee = rng.randrange(index)
+        lines += ['  if (d > 0)',
+                  '    r += f%d(r >> %d, d - 1);' % (callee, rng.randrange(4))]
+    if rng.random() < params.switch_density:
+        lines += ['  switch (r & 7u) {']
+        for case in range(7):
+            lines += ['  case %d:' % case,
+                      '    r += %du;' % rng.randrange(1, 1 << 12),
+                      '    break;']
+        lines += ['  default:',
+                  '    r -= %du;' % rng.randrange(1, 1 << 12),
+                  '  }']
+    if num_globals > 0 and rng.random() < 0.25:
+        lines += ['  g%d += r & 0xffu;' % rng.randrange(num_globals)]
+    return lines
+
+
+def generate(params):
+    rng = random.Random(params.seed)
+    lines = ['/* Generated by gen-scaling-input.py: functions=%d blocks=%d '
+             'globals=%d' % (params.functions, params.blocks, params.globals),
+             '   call-density=%g switch-density=%g seed=%d */' %
+             (params.call_density, params.switch_density, params.seed),
+             '',
+             '#include <stdio.h>',
+             '']
+    for g in range(params.globals):
+        lines += ['unsigned g%d = %du;' % (g, rng.randrange(1 << 16))]
+    if params.globals > 0:
+        lines += ['']
+    for index in range(params.functions):
+        lines += ['unsigned f%d(unsigned x, unsigned d) {' % index,
+                  '  unsigned r = x;']
+        for _ in range(params.blocks):
+            lines += generate_block(rng, index, params)
+        lines += ['  return r;', '}', '']
+    lines += ['int main(void) {', '  unsigned s = 0;']
+    first_called = max(params.functions - MAIN_CALLS, 0)
+    for index in range(first_called, params.functions):
+        lines += ['  s += f%d(%du, %d);' % (index, index, CALL_DEPTH)]
+    lines += ['  printf("checksum %u\\n", s);', '  return 0;', '}', '']
+    return '\n'.join(lines)
+
+
+def main():
+    params = get_args()
+    if params.functions < 1 or params.blocks < 0 or params.globals < 0:
+        sys.exit('Invalid size of program to generate')
+    program = generate(params)
+    if params.output == '-':
+        sys.stdout.write(program)
+    else:
+        with open(params.output, 'w') as f:
+            f.write(program)
+
+
+if __name__ == '__main__':
+    main()
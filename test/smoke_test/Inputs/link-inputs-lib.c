@@ -0,0 +1,10 @@
+int counter = 100;
+
+int factorial(int n) {
+  if (n == 0) {
+    return 1;
+  }
+  return n * factorial(n - 1);
+}
+
+int next_count(void) { return counter++; }
@@ -0,0 +1,25 @@
+// REQUIRES: system-linux
+// RUN: clang -o %T/liblink-inputs-lib.so %S/Inputs/link-inputs-lib.c -fPIC -shared
+// RUN: clang -o %t %s -L%T/ -llink-inputs-lib
+// RUN: llvm-mctoll -d -link-inputs %t %T/liblink-inputs-lib.so
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// CHECK: Factorial of 10 3628800
+// CHECK-NEXT: Count 105
+
+// The raised executable is built without the library. So calls to library
+// functions and references to library variables are resolved to the
+// definitions raised from the library.
+
+#include <stdio.h>
+
+extern int counter;
+extern int factorial(int n);
+extern int next_count(void);
+
+int main() {
+  printf("Factorial of 10 %d\n", factorial(10));
+  counter += 5;
+  printf("Count %d\n", next_count());
+  return 0;
+}
@@ -0,0 +1,11 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s
+// RUN: llvm-mctoll -d -run -run-arg=one -run-arg=two %t 2>&1 | FileCheck %s
+// CHECK: Number of arguments 3
+
+#include <stdio.h>
+
+int main(int argc, char **argv) {
+  printf("Number of arguments %d\n", argc);
+  return 0;
+}